@@ -9,10 +9,453 @@
 #include <cctype>
 #include <variant>
 #include <set> // For tracking keys
+#include <unordered_map>
+#include <unordered_set>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <optional>
+#include <cstdint>
+#include <memory>
+#include <atomic>
+#include <array>
+#include <tuple>
+#include <cstring>
+#include <charconv>
+#include <string_view>
+#include <chrono>
+#include <thread>
+#include <memory_resource>
+#include <sstream>
+#include <limits>
+#include <cstdlib>
+#include <new>
 
 using namespace std;
 using json = nlohmann::json;
 
+// Interned parameter keys: every distinct key string gets one stable ID shared by all param structs,
+// so stored params carry a 4-byte key instead of their own string copy.
+using ParamKey = uint32_t;
+
+class StringInterner {
+public:
+    static StringInterner& instance() {
+        static StringInterner interner;
+        return interner;
+    }
+
+    ParamKey intern(const string& s) {
+        {
+            shared_lock<shared_mutex> lock(mtx);
+            auto it = ids.find(s);
+            if (it != ids.end()) return it->second;
+        }
+        unique_lock<shared_mutex> lock(mtx);
+        auto [it, inserted] = ids.try_emplace(s, static_cast<ParamKey>(names.size()));
+        if (inserted) names.push_back(s);
+        return it->second;
+    }
+
+    // Lookup without inserting (getters must not grow the table for absent keys)
+    optional<ParamKey> find(const string& s) const {
+        shared_lock<shared_mutex> lock(mtx);
+        auto it = ids.find(s);
+        if (it == ids.end()) return nullopt;
+        return it->second;
+    }
+
+    const string& name(ParamKey id) const {
+        shared_lock<shared_mutex> lock(mtx);
+        return names[id]; // deque keeps references stable while other threads intern
+    }
+
+private:
+    mutable shared_mutex mtx;
+    unordered_map<string, ParamKey> ids;
+    deque<string> names;
+};
+
+// Load diagnostics: loaders record compact (code, context, key, value) entries into a per-thread ring
+// instead of writing to cerr, and the buffered entries are filtered, deduplicated and emitted in one batch.
+// Strings are interned in a table owned by the recording thread, so the record path takes no lock.
+enum class DiagSeverity : uint8_t { Info, Warning, Error };
+
+enum class DiagCode : uint8_t {
+    NonStringInArray,
+    FloatParseFailed,
+    FloatNotNumber,
+    FloatArrayParseFailed,
+    ExpectedObject,
+    InvalidEntry,
+    MissingSection,
+    LayoutFull,
+    NewParamDiscovered,
+    TypeMismatch,
+    MissingRequired,
+    UnknownField,
+    AliasRenamed,
+    EnvelopeInferred,
+    FileNotOpened,
+    GroupNotFound,
+    DuplicateSection,
+    SkdLoaded,
+    SkdFallback,
+    Count
+};
+
+struct DiagCodeInfo {
+    const char* name;  // Stable identifier for JSON output
+    const char* tag;   // Legacy text prefix
+    DiagSeverity severity;
+    const char* format;  // {context}, {key} and {value} are substituted at emission time
+};
+
+inline const DiagCodeInfo& diagInfo(DiagCode code) {
+    static const DiagCodeInfo table[] = {
+        {"non_string_in_array", "[TypeError]", DiagSeverity::Error, "Non-string in string array at {context}: {value}"},
+        {"float_parse_failed", "[TypeError]", DiagSeverity::Error, "Can't parse float in field {context} ({key}): {value}"},
+        {"float_not_number", "[TypeError]", DiagSeverity::Error, "Can't parse float (not number/string) at {context}: {value}"},
+        {"float_array_parse_failed", "[TypeError]", DiagSeverity::Error, "Can't parse float in array at {context}: {value}"},
+        {"expected_object", "[TypeError]", DiagSeverity::Error, "Expected {key} for {context}, got {value}"},
+        {"invalid_entry", "[TypeError]", DiagSeverity::Error, "Invalid '{key}' in {context}: {value}"},
+        {"missing_section", "[TypeError]", DiagSeverity::Error, "'{key}' not found or not an {value} in {context}"},
+        {"layout_full", "[Warn]", DiagSeverity::Warning, "Layout for '{context}' is full; '{key}' stays a keyed param."},
+        {"new_param_discovered", "[AutoDiscovery]", DiagSeverity::Info, "New param '{key}' detected at {context}. Schema update suggested: Define displayName/units/required for type {value}"},
+        {"type_mismatch", "[TypeError]", DiagSeverity::Error, "Type mismatch for key '{key}' at {context}: {value}"},
+        {"missing_required", "[Warning]", DiagSeverity::Warning, "Missing required param '{key}' in {context}. Defaulting if possible."},
+        {"unknown_field", "[Warning]", DiagSeverity::Warning, "Unknown field '{key}' in {context}. Stored but suggest schema update."},
+        {"alias_renamed", "[Mapping]", DiagSeverity::Info, "Renamed alias '{key}' to canonical '{value}' for context: {context}"},
+        {"envelope_inferred", "[AutoInfer]", DiagSeverity::Info, "Compacted {value} array detected in {context}—mapped to {key}."},
+        {"file_not_opened", "[Warn]", DiagSeverity::Warning, "Couldn't open {context}"},
+        {"group_not_found", "[Warn]", DiagSeverity::Warning, "Structure section group '{key}' not found in configs, skipping"},
+        {"duplicate_section", "[Warn]", DiagSeverity::Warning, "Structure section '{key}' repeats group '{value}'; effective params keep the first entry"},
+        {"skd_loaded", "[Info]", DiagSeverity::Info, "Loaded SKD from {context}"},
+        {"skd_fallback", "[Warn]", DiagSeverity::Warning, "SKD file {context} {value}—using hardcoded fallback."},
+    };
+    static_assert(sizeof(table) / sizeof(table[0]) == static_cast<size_t>(DiagCode::Count), "diagnostic table out of sync");
+    return table[static_cast<size_t>(code)];
+}
+
+inline const char* severityName(DiagSeverity severity) {
+    switch (severity) {
+        case DiagSeverity::Info: return "info";
+        case DiagSeverity::Warning: return "warning";
+        default: return "error";
+    }
+}
+
+inline optional<DiagSeverity> parseSeverity(const string& s) {
+    if (s == "info") return DiagSeverity::Info;
+    if (s == "warning" || s == "warn") return DiagSeverity::Warning;
+    if (s == "error") return DiagSeverity::Error;
+    return nullopt;
+}
+
+struct DiagRecord {
+    uint64_t seq;  // Global order, so records from several threads can be merged back in sequence
+    DiagCode code;
+    const string* context;  // Strings live in the recording thread's table
+    const string* key;
+    const string* value;
+    const string* once;    // Report-once key (nullptr for ordinary records)
+    const string* unless;  // Dropped if that report-once key was recorded earlier (nullptr for none)
+};
+
+// A record with its strings copied out, as drain() hands it to flush()
+struct DiagEntry {
+    uint64_t seq;
+    DiagCode code;
+    string context, key, value;
+    optional<string> once, unless;
+};
+
+class Diagnostics {
+    struct SeqRange {
+        uint64_t next = 0, end = 0;
+        bool active = false; // Inside a SequenceScope, even once the range is used up
+    };
+
+public:
+    enum class Format { Text, Json };
+
+    static Diagnostics& instance() {
+        static Diagnostics diagnostics;
+        return diagnostics;
+    }
+
+    void setMinSeverity(DiagSeverity severity) { minSeverity.store(static_cast<uint8_t>(severity), memory_order_relaxed); }
+    void setFormat(Format f) { format = f; }
+    void setOutputFile(const string& path) { outputFile = path; }
+
+    bool enabled(DiagCode code) const {
+        return static_cast<uint8_t>(diagInfo(code).severity) >= minSeverity.load(memory_order_relaxed);
+    }
+
+    static constexpr uint64_t SEQ_BLOCK = uint64_t(1) << 32;
+
+    /**
+     * Ordered sequence numbers for parallel work: reserve one range per task up front (in the order a
+     * serial run would reach them), and have each task record inside a SequenceScope on its range.
+     * flush() then merges the records exactly as if the tasks had run one after another. Inside a
+     * scope the ranges are carved from the current one, so tasks can split again.
+     * Returns the first range's start and the size of each range.
+     */
+    pair<uint64_t, uint64_t> reserveSequence(size_t count) {
+        SeqRange& range = localRange();
+        if (range.next < range.end) {
+            // Keep an equal share for whatever the caller records after the tasks
+            uint64_t size = (range.end - range.next) / (count + 1);
+            uint64_t first = range.next;
+            range.next += size * count;
+            return {first, size};
+        }
+        if (range.active) outOfRange.fetch_add(1, memory_order_relaxed);
+        return {nextSeq.fetch_add(count * SEQ_BLOCK, memory_order_relaxed), SEQ_BLOCK};
+    }
+
+    class SequenceScope {
+    public:
+        SequenceScope(uint64_t first, uint64_t size) : saved(localRange()) { localRange() = {first, first + size, true}; }
+        ~SequenceScope() { localRange() = saved; }
+        SequenceScope(const SequenceScope&) = delete;
+        SequenceScope& operator=(const SequenceScope&) = delete;
+
+    private:
+        SeqRange saved;
+    };
+
+    /**
+     * Record one diagnostic. Filtered codes return before any string is touched; otherwise the strings are
+     * interned in the calling thread's own table and the record is pushed to its ring. Neither step locks:
+     * only a thread's first record (registering its ring) and a full ring (overflow list) take a mutex.
+     */
+    void record(DiagCode code, const string& context, const string& key = "", const string& value = "") {
+        if (!enabled(code)) return;
+        Ring& ring = localRing();
+        push(ring, {takeSeq(), code, ring.intern(context), ring.intern(key), ring.intern(value), nullptr, nullptr});
+    }
+
+    /**
+     * Record a diagnostic that is reported only for the earliest record (in sequence order) sharing
+     * `onceKey` with it. Every occurrence records; flush() keeps the first, so which occurrence is
+     * named does not depend on which thread got there first.
+     */
+    void recordOnce(DiagCode code, const string& onceKey, const string& context, const string& key, const string& value) {
+        if (!enabled(code)) return;
+        Ring& ring = localRing();
+        push(ring, {takeSeq(), code, ring.intern(context), ring.intern(key), ring.intern(value), ring.intern(onceKey), nullptr});
+    }
+
+    // Record a diagnostic that is dropped if a report-once record for `onceKey` precedes it in sequence order
+    void recordUnless(DiagCode code, const string& onceKey, const string& context, const string& key, const string& value = "") {
+        if (!enabled(code)) return;
+        Ring& ring = localRing();
+        push(ring, {takeSeq(), code, ring.intern(context), ring.intern(key), ring.intern(value), nullptr, ring.intern(onceKey)});
+    }
+
+    void record(DiagCode code, const string& context, const string& key, const json& value) {
+        if (enabled(code)) record(code, context, key, value.dump());
+    }
+
+    /**
+     * Drain every ring, merge in record order, collapse identical records and emit them in the configured
+     * format. Returns the number of unique entries written.
+     */
+    size_t flush() {
+        vector<DiagEntry> drained = drain();
+        size_t unordered = outOfRange.exchange(0, memory_order_relaxed);
+        // Report-once records: the earliest per key wins (including against earlier flushes), and records
+        // conditional on a key only survive if they precede it. drained is in sequence order.
+        drained.erase(remove_if(drained.begin(), drained.end(), [&](const DiagEntry& rec) {
+                          if (rec.unless) return reportedOnce.count(*rec.unless) > 0;
+                          return rec.once && !reportedOnce.insert(*rec.once).second;
+                      }), drained.end());
+        if (drained.empty()) return 0;
+
+        // Dedup on (code, context, key, value), keeping first-occurrence order
+        struct Entry { const DiagEntry* rec; size_t count; };
+        vector<Entry> entries;
+        map<tuple<DiagCode, const string&, const string&, const string&>, size_t> seen;
+        size_t bySeverity[3] = {0, 0, 0};
+        for (const DiagEntry& rec : drained) {
+            auto [it, inserted] = seen.try_emplace(tie(rec.code, rec.context, rec.key, rec.value), entries.size());
+            if (inserted) entries.push_back({&rec, 1});
+            else ++entries[it->second].count;
+            ++bySeverity[static_cast<size_t>(diagInfo(rec.code).severity)];
+        }
+
+        ofstream file;
+        if (!outputFile.empty()) {
+            file.open(outputFile, outputStarted ? ios::app : ios::trunc); // Later flushes append to the same file
+            outputStarted = true;
+            if (!file) cerr << "[Warn] Couldn't open diagnostics output " << outputFile << "—writing to stderr." << endl;
+        }
+        ostream& out = file.is_open() ? static_cast<ostream&>(file) : cerr;
+
+        if (format == Format::Json) {
+            json j;
+            j["diagnostics"] = json::array();
+            for (const Entry& e : entries) {
+                const DiagCodeInfo& info = diagInfo(e.rec->code);
+                j["diagnostics"].push_back({
+                    {"code", info.name},
+                    {"severity", severityName(info.severity)},
+                    {"context", e.rec->context},
+                    {"key", e.rec->key},
+                    {"value", e.rec->value},
+                    {"count", e.count},
+                    {"message", message(*e.rec)}
+                });
+            }
+            j["summary"] = {{"records", drained.size()}, {"unique", entries.size()},
+                            {"info", bySeverity[0]}, {"warning", bySeverity[1]}, {"error", bySeverity[2]}};
+            if (unordered) j["summary"]["out_of_range"] = unordered;
+            out << j.dump(2) << endl;
+        } else {
+            for (const Entry& e : entries) {
+                out << diagInfo(e.rec->code).tag << " " << message(*e.rec);
+                if (e.count > 1) out << " (x" << e.count << ")";
+                out << "\n";
+            }
+            out << "[Info] Load diagnostics: " << drained.size() << " record(s), " << entries.size() << " unique ("
+                << bySeverity[2] << " error, " << bySeverity[1] << " warning, " << bySeverity[0] << " info)" << endl;
+            if (unordered) {
+                out << "[Warn] " << unordered << " diagnostic sequence number(s) fell outside their task's reserved range;"
+                    << " those records may be out of load order" << endl;
+            }
+        }
+        return entries.size();
+    }
+
+private:
+    struct Ring {
+        static constexpr size_t CAPACITY = 1024;
+        array<DiagRecord, CAPACITY> records;
+        atomic<size_t> head{0};  // Advanced only by the owning thread
+        atomic<size_t> tail{0};  // Advanced only by drain(), after it has copied the records' strings
+        // Owner-only string table that records point into (node-based, so pointers survive inserts).
+        // The owner clears it after a flush once everything it recorded has been drained.
+        unordered_set<string> strings;
+        uint64_t flushesSeen = 0;
+
+        const string* intern(const string& s) { return &*strings.insert(s).first; }
+    };
+
+    atomic<uint8_t> minSeverity{static_cast<uint8_t>(DiagSeverity::Info)};
+    atomic<uint64_t> nextSeq{0};
+    atomic<uint64_t> flushes{0};
+    atomic<size_t> outOfRange{0}; // Sequence numbers a scope needed past its reserved range since the last flush
+    Format format = Format::Text;
+    string outputFile;
+    bool outputStarted = false;
+    mutex registryMutex;
+    vector<shared_ptr<Ring>> rings;  // Kept until drained after their thread exits so nothing recorded is lost
+    mutex overflowMutex;
+    vector<DiagEntry> overflow;  // Holds copies, so nothing here points into a ring's table
+    set<string> reportedOnce; // Report-once keys already seen
+
+    static DiagEntry resolve(const DiagRecord& rec) {
+        return {rec.seq, rec.code, *rec.context, *rec.key, *rec.value,
+                rec.once ? optional<string>(*rec.once) : nullopt, rec.unless ? optional<string>(*rec.unless) : nullopt};
+    }
+
+    // Pushed to the calling thread's ring without taking a lock
+    void push(Ring& ring, const DiagRecord& rec) {
+        size_t head = ring.head.load(memory_order_relaxed);
+        if (head - ring.tail.load(memory_order_acquire) == Ring::CAPACITY) {
+            // Ring full: this record goes to the shared overflow list (rare, so a lock is fine here)
+            lock_guard<mutex> lock(overflowMutex);
+            overflow.push_back(resolve(rec));
+            return;
+        }
+        ring.records[head % Ring::CAPACITY] = rec;
+        ring.head.store(head + 1, memory_order_release);
+    }
+
+    static SeqRange& localRange() {
+        thread_local SeqRange range;
+        return range;
+    }
+
+    // Next number from the thread's reserved range if one is active, else from the global counter.
+    // A used-up range falls back too, but is counted so flush() can say the order may be off.
+    uint64_t takeSeq() {
+        SeqRange& range = localRange();
+        if (range.next < range.end) return range.next++;
+        if (range.active) outOfRange.fetch_add(1, memory_order_relaxed);
+        return nextSeq.fetch_add(1, memory_order_relaxed);
+    }
+
+    // The calling thread's ring. After a flush its string table is dropped as soon as nothing
+    // undrained can point into it (every record up to head has been drained and copied).
+    Ring& localRing() {
+        thread_local shared_ptr<Ring> ring;
+        if (!ring) {
+            ring = make_shared<Ring>();
+            lock_guard<mutex> lock(registryMutex);
+            rings.push_back(ring);
+        }
+        uint64_t flushed = flushes.load(memory_order_relaxed);
+        if (ring->flushesSeen != flushed &&
+            ring->tail.load(memory_order_acquire) == ring->head.load(memory_order_relaxed)) {
+            ring->strings.clear();
+            ring->flushesSeen = flushed;
+        }
+        return *ring;
+    }
+
+    vector<DiagEntry> drain() {
+        vector<DiagEntry> out;
+        {
+            lock_guard<mutex> lock(overflowMutex);
+            out.swap(overflow);
+        }
+        {
+            lock_guard<mutex> lock(registryMutex);
+            for (const auto& ring : rings) {
+                size_t head = ring->head.load(memory_order_acquire);
+                size_t tail = ring->tail.load(memory_order_relaxed);
+                for (size_t i = tail; i < head; ++i) out.push_back(resolve(ring->records[i % Ring::CAPACITY]));
+                ring->tail.store(head, memory_order_release);
+            }
+            // Rings of exited threads are fully drained now; drop them with their tables
+            rings.erase(remove_if(rings.begin(), rings.end(), [](const shared_ptr<Ring>& ring) { return ring.use_count() == 1; }),
+                        rings.end());
+        }
+        flushes.fetch_add(1, memory_order_relaxed);
+        sort(out.begin(), out.end(), [](const DiagEntry& a, const DiagEntry& b) { return a.seq < b.seq; });
+        return out;
+    }
+
+    static string message(const DiagEntry& rec) {
+        string text = diagInfo(rec.code).format;
+        const pair<const char*, const string*> fields[] = {{"{context}", &rec.context}, {"{key}", &rec.key}, {"{value}", &rec.value}};
+        for (const auto& [placeholder, field] : fields) {
+            size_t pos = text.find(placeholder);
+            if (pos != string::npos) text.replace(pos, strlen(placeholder), *field);
+        }
+        return text;
+    }
+};
+
+// Shorthand used by the loaders; JSON values are only dumped when the code passes the severity filter
+inline void diag(DiagCode code, const string& context, const string& key = "", const string& value = "") {
+    Diagnostics::instance().record(code, context, key, value);
+}
+inline void diag(DiagCode code, const string& context, const string& key, const char* value) {
+    Diagnostics::instance().record(code, context, key, string(value));
+}
+inline void diag(DiagCode code, const string& context, const string& key, const json& value) {
+    Diagnostics::instance().record(code, context, key, value);
+}
+inline void diagOnce(DiagCode code, const string& onceKey, const string& context, const string& key, const string& value) {
+    Diagnostics::instance().recordOnce(code, onceKey, context, key, value);
+}
+inline void diagUnless(DiagCode code, const string& onceKey, const string& context, const string& key) {
+    Diagnostics::instance().recordUnless(code, onceKey, context, key);
+}
+
 // Helper: convert string to lowercase
 string lower(const string& s) {
     string out = s;
@@ -38,7 +481,7 @@ vector<string> getStringVec(const json& j, const string& ctx = "") {
         for (size_t i = 0; i < j.size(); ++i) {
             if (j[i].is_string()) out.push_back(j[i].get<string>());
             else if (j[i].is_number()) out.push_back(to_string(j[i].get<float>()));
-            else cerr << "[TypeError] Non-string in string array at " << ctx << "[" << i << "]: " << j[i] << "\n";
+            else diag(DiagCode::NonStringInArray, ctx + "[" + to_string(i) + "]", "", j[i]);
         }
     } else if (j.is_string()) {
         out.push_back(j.get<string>());
@@ -48,12 +491,118 @@ vector<string> getStringVec(const json& j, const string& ctx = "") {
     return out;
 }
 
-// Enhanced: parse float or string with units (ms, s, Hz)
-// Defensive: Get float or 0 if not parsable, print errors
+// Moves a parsed string list into an allocator-aware vector, keeping the destination's resource
+inline void assignOscTypes(pmr::vector<string>& dst, vector<string>&& src) {
+    dst.assign(make_move_iterator(src.begin()), make_move_iterator(src.end()));
+}
+
+// Unit-aware numeric parsing: "600ms", "3s", "800Hz", "2.5kHz", "-6dB", "50%", "12cents".
+// Values are normalized to canonical units (time -> ms, frequency -> Hz, percent -> fraction);
+// dB and cents are kept as-is. Parsing never throws; failures come back as a status code.
+enum class ParseStatus : uint8_t { Ok, Keyword, Empty, InvalidNumber, UnknownUnit, NotNumeric };
+
+inline const char* parseStatusName(ParseStatus status) {
+    switch (status) {
+        case ParseStatus::Ok: return "ok";
+        case ParseStatus::Keyword: return "keyword";
+        case ParseStatus::Empty: return "empty";
+        case ParseStatus::InvalidNumber: return "invalid number";
+        case ParseStatus::UnknownUnit: return "unknown unit";
+        default: return "not numeric";
+    }
+}
+
+struct UnitParse {
+    float value = 0.0f;
+    ParseStatus status = ParseStatus::Ok;
+    bool ok() const { return status == ParseStatus::Ok || status == ParseStatus::Keyword; }
+};
+
+struct UnitSpec {
+    string_view suffix;
+    float scale;
+};
+
+// Matched case-sensitively after the number ("ms" vs "Ms" matters for time vs nothing)
+inline constexpr UnitSpec UNIT_TABLE[] = {
+    {"ms", 1.0f}, {"s", 1000.0f}, {"Hz", 1.0f}, {"kHz", 1000.0f}, {"dB", 1.0f}, {"%", 0.01f}, {"cents", 1.0f}
+};
+
+// Placeholder values some presets use for automated parameters; they parse as zero
+inline constexpr string_view ZERO_KEYWORDS[] = {"AI-dynamic", "AI-driven", "random", "automated"};
+
+inline UnitParse parseUnitFloat(string_view text) {
+    auto isSpace = [](char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; };
+    while (!text.empty() && isSpace(text.front())) text.remove_prefix(1);
+    while (!text.empty() && isSpace(text.back())) text.remove_suffix(1);
+    if (text.empty()) return {0.0f, ParseStatus::Empty};
+    for (string_view keyword : ZERO_KEYWORDS) {
+        if (text == keyword) return {0.0f, ParseStatus::Keyword};
+    }
+
+    const char* first = text.data();
+    const char* last = text.data() + text.size();
+    if (*first == '+') ++first; // from_chars rejects a leading '+'
+    float value = 0.0f;
+    auto [ptr, ec] = from_chars(first, last, value);
+    if (ec != errc() || ptr == first) return {0.0f, ParseStatus::InvalidNumber};
+
+    string_view unit(ptr, static_cast<size_t>(last - ptr));
+    while (!unit.empty() && isSpace(unit.front())) unit.remove_prefix(1);
+    if (unit.empty()) return {value, ParseStatus::Ok};
+    for (const UnitSpec& spec : UNIT_TABLE) {
+        if (unit == spec.suffix) return {value * spec.scale, ParseStatus::Ok};
+    }
+    return {value, ParseStatus::UnknownUnit};
+}
+
+// Parse one JSON value (number, unit string, or array whose first element is a number) without reporting
+inline UnitParse parseFlexible(const json& j) {
+    if (j.is_number()) return {j.get<float>(), ParseStatus::Ok};
+    if (j.is_array() && !j.empty() && j[0].is_number()) return {j[0].get<float>(), ParseStatus::Ok}; // Use first element
+    if (j.is_string()) return parseUnitFloat(j.get_ref<const string&>());
+    if (j.is_null()) return {0.0f, ParseStatus::Ok};
+    return {0.0f, ParseStatus::NotNumeric};
+}
+
+// Defensive: Get float or 0 if not parsable, recording a diagnostic
 float getFlexibleFloat(const json& j, const string& ctx = "") {
+    UnitParse parsed = parseFlexible(j);
+    if (parsed.ok()) return parsed.value;
+    if (parsed.status == ParseStatus::NotNumeric) diag(DiagCode::FloatNotNumber, ctx, "", j);
+    else diag(DiagCode::FloatParseFailed, ctx, parseStatusName(parsed.status), j);
+    return 0.0f;
+}
+
+/**
+ * Batch form for numeric arrays (detune_range, mix_ratios, ...). Appends one value per element (0 for
+ * failures) and returns how many elements failed; their indices go to `failed` when it is provided.
+ * A non-array value is parsed as a single element.
+ */
+size_t parseUnitFloats(const json& values, vector<float>& out, vector<size_t>* failed = nullptr) {
+    size_t failures = 0;
+    auto parseOne = [&](const json& v, size_t index) {
+        UnitParse parsed = parseFlexible(v);
+        out.push_back(parsed.ok() ? parsed.value : 0.0f);
+        if (!parsed.ok()) {
+            ++failures;
+            if (failed) failed->push_back(index);
+        }
+    };
+    if (values.is_array()) {
+        out.reserve(out.size() + values.size());
+        for (size_t i = 0; i < values.size(); ++i) parseOne(values[i], i);
+    } else {
+        parseOne(values, 0);
+    }
+    return failures;
+}
+
+// Previous string::find/stof implementation, kept as the baseline for --bench-units
+float legacyFlexibleFloat(const json& j) {
     try {
         if (j.is_number()) return j.get<float>();
-        if (j.is_array() && j.size() > 0 && j[0].is_number()) return j[0].get<float>(); // Use first element
+        if (j.is_array() && j.size() > 0 && j[0].is_number()) return j[0].get<float>();
         if (j.is_string()) {
             string val = j.get<string>();
             size_t pos;
@@ -63,38 +612,23 @@ float getFlexibleFloat(const json& j, const string& ctx = "") {
                 return stof(val.substr(0, pos)) * 1000.0f;
             if ((pos = val.find("Hz")) != string::npos)
                 return stof(val.substr(0, pos));
-            // Allow some "AI-driven" etc to parse as zero
             vector<string> allowed = {"AI-dynamic", "AI-driven", "random", "automated"};
             if (find(allowed.begin(), allowed.end(), val) != allowed.end())
                 return 0.0f;
             return stof(val);
         }
-        if (j.is_null()) return 0.0f;
     } catch (...) {
-        cerr << "[TypeError] Can't parse float in field " << ctx << ": " << j << endl;
     }
-    cerr << "[TypeError] Can't parse float (not number/string) at " << ctx << ": " << j << endl;
     return 0.0f;
 }
 
-// Defensive: get vector<float> or empty if not all numbers
+// Defensive: get vector<float>; elements that don't parse become 0 and are reported
 vector<float> getFloatVec(const json& j, const string& ctx = "") {
+    if (!j.is_array()) return {getFlexibleFloat(j, ctx)};
     vector<float> out;
-    if (j.is_array()) {
-        for (size_t i = 0; i < j.size(); ++i) {
-            try {
-                out.push_back(getFlexibleFloat(j[i], ctx + "[" + to_string(i) + "]"));
-            } catch (...) {
-                cerr << "[TypeError] Can't parse float in array at " << ctx << "[" << i << "]: " << j[i] << "\n";
-            }
-        }
-    } else {
-        try {
-            out.push_back(getFlexibleFloat(j, ctx));
-        } catch (...) {
-            cerr << "[TypeError] Can't parse float (single) at " << ctx << ": " << j << "\n";
-        }
-    }
+    vector<size_t> failed;
+    parseUnitFloats(j, out, &failed);
+    for (size_t i : failed) diag(DiagCode::FloatArrayParseFailed, ctx + "[" + to_string(i) + "]", "", j[i]);
     return out;
 }
 
@@ -160,12 +694,12 @@ struct SoundCharacteristics {
                     } else if (emotion.is_object() && emotion.contains("tag") && emotion["tag"].is_string()) {
                         emotional.emplace_back(emotion["tag"].get<string>(), emotion.value("weight", 1.0f));
                     } else {
-                        cerr << "[TypeError] Invalid emotional entry: " << emotion << endl;
+                        diag(DiagCode::InvalidEntry, "SoundCharacteristics", "emotional", emotion);
                     }
                 }
             }
         } else {
-            cerr << "[TypeError] Expected object for SoundCharacteristics, got " << j.type_name() << endl;
+            diag(DiagCode::ExpectedObject, "SoundCharacteristics", "object", j.type_name());
         }
     }
 
@@ -205,7 +739,7 @@ struct TopologicalMetadata {
             if (j.contains("spectral_complexity") && j["spectral_complexity"].is_string()) spectralComplexity = j["spectral_complexity"].get<string>();
             if (j.contains("manifold_position") && j["manifold_position"].is_string()) manifoldPosition = j["manifold_position"].get<string>();
         } else {
-            cerr << "[TypeError] Expected object for TopologicalMetadata, got " << j.type_name() << endl;
+            diag(DiagCode::ExpectedObject, "TopologicalMetadata", "object", j.type_name());
         }
     }
 
@@ -226,6 +760,7 @@ struct ParamMeta {
     string description = ""; // Optional for docs
     bool required = false;
     string paramType = "float"; // e.g., "float", "bool", "string", "vector<float>", "vector<string>"
+    bool discovered = false; // Auto-discovered: records the key but does not constrain its type or range
 
     void from_json(const json& j) {
         if (j.is_object()) {
@@ -237,7 +772,7 @@ struct ParamMeta {
             if (j.contains("required") && j["required"].is_boolean()) required = j["required"].get<bool>();
             if (j.contains("paramType") && j["paramType"].is_string()) paramType = j["paramType"].get<string>();
         } else {
-            cerr << "[TypeError] Expected object for ParamMeta, got " << j.type_name() << endl;
+            diag(DiagCode::ExpectedObject, "ParamMeta", "object", j.type_name());
         }
     }
 
@@ -254,67 +789,367 @@ struct ParamMeta {
     }
 };
 
-// BaseParamStruct: Map-based for params, with schema, validation, and discovery
+// ParamLayout: a registered schema compiled to fixed slots. Each float/bool param gets a slot index,
+// so instances keep those values in one contiguous array and callers resolve a key to a handle once.
+struct ParamLayout {
+    static constexpr size_t MAX_SLOTS = 64; // Presence is tracked in one 64-bit mask per instance
+
+    string type;
+    vector<string> names;  // slot -> param name
+    vector<ParamMeta> metas;  // slot -> schema entry
+    unordered_map<ParamKey, uint32_t> slotByKey;
+
+    static shared_ptr<const ParamLayout> compile(const string& type, const map<string, ParamMeta>& schema) {
+        auto layout = make_shared<ParamLayout>();
+        layout->type = type;
+        for (const auto& [name, meta] : schema) {
+            if (meta.paramType != "float" && meta.paramType != "bool") continue; // Others stay in the flat store
+            if (layout->names.size() == MAX_SLOTS) {
+                diag(DiagCode::LayoutFull, type, name);
+                continue;
+            }
+            layout->slotByKey[StringInterner::instance().intern(name)] = static_cast<uint32_t>(layout->names.size());
+            layout->names.push_back(name);
+            layout->metas.push_back(meta);
+        }
+        return layout;
+    }
+
+    optional<uint32_t> slotOf(ParamKey key) const {
+        auto it = slotByKey.find(key);
+        if (it == slotByKey.end()) return nullopt;
+        return it->second;
+    }
+
+    bool isBool(uint32_t slot) const { return metas[slot].paramType == "bool"; }
+};
+
+// Typed accessor for one layout slot; resolve with BaseParamStruct::handle(type, name) once and reuse
+struct ParamHandle {
+    const ParamLayout* layout = nullptr;
+    uint32_t slot = 0;
+
+    explicit operator bool() const { return layout != nullptr; }
+};
+
+// One immutable version of every schema: the registered types (e.g. FX) with their compiled layouts, and the
+// per-struct-type schemas (loaded entries plus auto-discovered keys).
+struct SchemaSnapshot {
+    uint64_t generation = 0;
+    string version = "1.1"; // Initial version
+    map<string, map<string, ParamMeta>> registered;
+    map<string, shared_ptr<const ParamLayout>> layouts;
+    map<string, map<string, ParamMeta>> scoped;
+
+    const map<string, ParamMeta>* scope(const string& name) const {
+        auto it = scoped.find(name);
+        return it != scoped.end() ? &it->second : nullptr;
+    }
+
+    const ParamMeta* registeredParam(const string& type, const string& key) const {
+        auto typeIt = registered.find(type);
+        if (typeIt == registered.end()) return nullptr;
+        auto it = typeIt->second.find(key);
+        return it != typeIt->second.end() ? &it->second : nullptr;
+    }
+};
+
+/**
+ * Copy-on-write schema registry. Readers take shared ownership of the current snapshot with one atomic
+ * load and never block; a snapshot is freed once the registry and its last reader let go of it. Writers
+ * copy the snapshot, edit the copy and publish it under a writer mutex. Keys discovered while a Batch is
+ * open (a config load) are collected aside and published together as one snapshot when it closes.
+ */
+class SchemaRegistry {
+public:
+    static shared_ptr<const SchemaSnapshot> current() {
+        return atomic_load_explicit(&state().head, memory_order_acquire);
+    }
+
+    // Publish a new snapshot if `edit` returns true; returns whether anything was published
+    template <typename Edit>
+    static bool update(Edit edit) {
+        State& st = state();
+        lock_guard<mutex> lock(st.writerMutex);
+        auto next = make_shared<SchemaSnapshot>(*st.head);
+        if (!edit(*next)) return false;
+        publish(st, std::move(next));
+        return true;
+    }
+
+    // Record an auto-discovered key; the first discovery wins, and an existing entry is never replaced
+    static void discover(const string& scope, const string& key, const ParamMeta& meta) {
+        State& st = state();
+        {
+            lock_guard<mutex> lock(st.writerMutex);
+            if (st.openBatches) {
+                st.pending[scope].try_emplace(key, meta);
+                return;
+            }
+        }
+        update([&](SchemaSnapshot& next) { return next.scoped[scope].try_emplace(key, meta).second; });
+    }
+
+    // Scope of one load: its discovered keys cost one snapshot, published when the outermost batch closes
+    class Batch {
+    public:
+        Batch() {
+            State& st = state();
+            lock_guard<mutex> lock(st.writerMutex);
+            ++st.openBatches;
+        }
+
+        ~Batch() {
+            State& st = state();
+            lock_guard<mutex> lock(st.writerMutex);
+            if (--st.openBatches || st.pending.empty()) return;
+            auto next = make_shared<SchemaSnapshot>(*st.head);
+            for (auto& [scope, entries] : st.pending) next->scoped[scope].merge(entries); // Keeps existing entries
+            st.pending.clear();
+            publish(st, std::move(next));
+        }
+
+        Batch(const Batch&) = delete;
+        Batch& operator=(const Batch&) = delete;
+    };
+
+private:
+    struct State {
+        mutex writerMutex; // Guards publishing, openBatches and pending
+        shared_ptr<const SchemaSnapshot> head = make_shared<SchemaSnapshot>(); // Written only with atomic_store
+        size_t openBatches = 0;
+        map<string, map<string, ParamMeta>> pending;
+    };
+
+    static void publish(State& st, shared_ptr<SchemaSnapshot> next) {
+        next->generation = st.head->generation + 1;
+        atomic_store_explicit(&st.head, shared_ptr<const SchemaSnapshot>(std::move(next)), memory_order_release);
+    }
+
+    static State& state() {
+        static State st;
+        return st;
+    }
+};
+
+// BaseParamStruct: flat sorted store of (interned key, tagged value), with a schema shared per struct type.
+// Structs of a registered type (see registerSchema) also hold that type's float/bool params in layout slots.
 struct BaseParamStruct {
-    map<string, float> floatParams;
-    map<string, bool> boolParams;
-    map<string, string> stringParams;
-    map<string, vector<float>> vectorParams;
-    map<string, vector<string>> stringVectorParams; // For vector<string> like "types"
-    map<string, variant<float, bool, string, vector<float>, vector<string>>> unifiedParams; // Updated unified for string vectors
+    enum class ParamKind : uint8_t { Float, Bool, String, FloatVector, StringVector };
+
+    // 12-byte slot: scalars inline, strings/vectors as an index into the matching side pool
+    struct ParamSlot {
+        ParamKey key;
+        ParamKind kind;
+        union {
+            float f;
+            bool b;
+            uint32_t ref;
+        };
+    };
 
-    map<string, ParamMeta> paramSchema; // Schema for validation/UI, now versioned
+    vector<ParamSlot> params; // Sorted by key ID, one slot per key
+    vector<string> stringPool;
+    vector<vector<float>> floatVectorPool;
+    vector<vector<string>> stringVectorPool;
 
-    // Static registry for types (e.g., FX) (C. Dynamic Registration)
-    static map<string, map<string, ParamMeta>> registeredSchemas;
-    static string schemaVersion; // Versioned schema
+    shared_ptr<const ParamLayout> layout; // Compiled layout of the registered type, if any
+    vector<float> layoutValues;           // One value per layout slot (bools as 0/1)
+    uint64_t layoutPresent = 0;           // Bit per slot that holds a value
 
+    // Schemas live in SchemaRegistry; each instance only names the per-type scope it reads and extends
+    explicit BaseParamStruct(const string& schemaScope = "params")
+        : schemaScope(&StringInterner::instance().name(StringInterner::instance().intern(schemaScope))) {}
+
+    // Registry for types (e.g., FX) (C. Dynamic Registration)
     static void registerSchema(const string& type, const map<string, ParamMeta>& schema) {
-        registeredSchemas[type] = schema;
+        auto layout = ParamLayout::compile(type, schema);
+        SchemaRegistry::update([&](SchemaSnapshot& next) {
+            next.registered[type] = schema;
+            next.layouts[type] = layout;
+            return true;
+        });
+    }
+
+    static shared_ptr<const ParamLayout> findLayout(const string& type) {
+        shared_ptr<const SchemaSnapshot> snap = SchemaRegistry::current();
+        auto it = snap->layouts.find(type);
+        return it != snap->layouts.end() ? it->second : nullptr;
+    }
+
+    // Resolve a registered param to its slot; an empty handle if the type or param has no slot
+    static ParamHandle handle(const string& type, const string& name) {
+        auto layoutPtr = findLayout(type);
+        optional<ParamKey> key = StringInterner::instance().find(name);
+        if (!layoutPtr || !key) return {};
+        optional<uint32_t> slot = layoutPtr->slotOf(*key);
+        return slot ? ParamHandle{layoutPtr.get(), *slot} : ParamHandle{};
+    }
+
+    // Bind this instance to the compiled layout of `type` (no-op for unregistered types)
+    void useLayout(const string& type) {
+        layout = findLayout(type);
+        layoutValues.assign(layout ? layout->names.size() : 0, 0.0f);
+        layoutPresent = 0;
+    }
+
+    // Slot accessors: no key lookup at all once the handle is resolved
+    bool hasSlot(ParamHandle h) const {
+        return h.layout == layout.get() && h.layout && ((layoutPresent >> h.slot) & 1u);
+    }
+
+    float getSlot(ParamHandle h, float defaultVal = 0.0f) const {
+        return hasSlot(h) ? layoutValues[h.slot] : defaultVal;
+    }
+
+    void setSlot(ParamHandle h, float v) {
+        if (h.layout != layout.get() || !h.layout) return;
+        layoutValues[h.slot] = v;
+        layoutPresent |= uint64_t{1} << h.slot;
+    }
+
+    // Helper getters with defaults; a key stored under another type reads as absent
+    float getFloat(ParamKey key, float defaultVal = 0.0f) const {
+        if (optional<uint32_t> s = layoutSlot(key, false)) {
+            return ((layoutPresent >> *s) & 1u) ? layoutValues[*s] : defaultVal;
+        }
+        const ParamSlot* slot = findSlot(key, ParamKind::Float);
+        return slot ? slot->f : defaultVal;
     }
 
-    // Helper getters with defaults (added getStringVector)
     float getFloat(const string& key, float defaultVal = 0.0f) const {
-        auto it = floatParams.find(key);
-        return (it != floatParams.end()) ? it->second : defaultVal;
+        optional<ParamKey> id = StringInterner::instance().find(key);
+        return id ? getFloat(*id, defaultVal) : defaultVal;
     }
 
     bool getBool(const string& key, bool defaultVal = false) const {
-        auto it = boolParams.find(key);
-        return (it != boolParams.end()) ? it->second : defaultVal;
+        optional<ParamKey> id = StringInterner::instance().find(key);
+        if (!id) return defaultVal;
+        if (optional<uint32_t> s = layoutSlot(*id, true)) {
+            return ((layoutPresent >> *s) & 1u) ? layoutValues[*s] != 0.0f : defaultVal;
+        }
+        const ParamSlot* slot = findSlot(*id, ParamKind::Bool);
+        return slot ? slot->b : defaultVal;
     }
 
     string getString(const string& key, const string& defaultVal = "") const {
-        auto it = stringParams.find(key);
-        return (it != stringParams.end()) ? it->second : defaultVal;
+        const ParamSlot* slot = findSlot(key, ParamKind::String);
+        return slot ? stringPool[slot->ref] : defaultVal;
     }
 
     vector<float> getVector(const string& key, const vector<float>& defaultVal = {}) const {
-        auto it = vectorParams.find(key);
-        return (it != vectorParams.end()) ? it->second : defaultVal;
+        const ParamSlot* slot = findSlot(key, ParamKind::FloatVector);
+        return slot ? floatVectorPool[slot->ref] : defaultVal;
     }
 
     vector<string> getStringVector(const string& key, const vector<string>& defaultVal = {}) const {
-        auto it = stringVectorParams.find(key);
-        return (it != stringVectorParams.end()) ? it->second : defaultVal;
+        const ParamSlot* slot = findSlot(key, ParamKind::StringVector);
+        return slot ? stringVectorPool[slot->ref] : defaultVal;
+    }
+
+    // Setters replace any previous value of the key, whatever its type
+    void setFloat(const string& key, float v) {
+        ParamKey id = StringInterner::instance().intern(key);
+        if (optional<uint32_t> s = layoutSlot(id, false)) {
+            setSlot(ParamHandle{layout.get(), *s}, v);
+            return;
+        }
+        slotFor(id, ParamKind::Float).f = v;
+    }
+
+    void setBool(const string& key, bool v) {
+        ParamKey id = StringInterner::instance().intern(key);
+        if (optional<uint32_t> s = layoutSlot(id, true)) {
+            setSlot(ParamHandle{layout.get(), *s}, v ? 1.0f : 0.0f);
+            return;
+        }
+        slotFor(id, ParamKind::Bool).b = v;
+    }
+
+    void setString(const string& key, const string& v) {
+        stringPool[slotFor(StringInterner::instance().intern(key), ParamKind::String).ref] = v;
+    }
+
+    void setVector(const string& key, const vector<float>& v) {
+        floatVectorPool[slotFor(StringInterner::instance().intern(key), ParamKind::FloatVector).ref] = v;
+    }
+
+    void setStringVector(const string& key, const vector<string>& v) {
+        stringVectorPool[slotFor(StringInterner::instance().intern(key), ParamKind::StringVector).ref] = v;
+    }
+
+    // Copy every param of other into this struct. Other's values win, except that a key already held
+    // as a later ParamKind keeps it (the precedence the old per-type maps had when serialized).
+    void mergeFrom(const BaseParamStruct& other) {
+        for (const ParamSlot& src : other.params) {
+            auto existing = lower_bound(params.begin(), params.end(), src.key,
+                                        [](const ParamSlot& slot, ParamKey k) { return slot.key < k; });
+            if (existing != params.end() && existing->key == src.key && existing->kind > src.kind) continue;
+            ParamSlot& dst = slotFor(src.key, src.kind);
+            switch (src.kind) {
+                case ParamKind::Float: dst.f = src.f; break;
+                case ParamKind::Bool: dst.b = src.b; break;
+                case ParamKind::String: stringPool[dst.ref] = other.stringPool[src.ref]; break;
+                case ParamKind::FloatVector: floatVectorPool[dst.ref] = other.floatVectorPool[src.ref]; break;
+                case ParamKind::StringVector: stringVectorPool[dst.ref] = other.stringVectorPool[src.ref]; break;
+            }
+        }
+        other.forEachLayoutValue([&](const string& name, bool isBool, float v) {
+            if (isBool) setBool(name, v != 0.0f);
+            else setFloat(name, v);
+        });
+    }
+
+    // Visit every present layout slot as (name, isBool, value)
+    template <typename Fn>
+    void forEachLayoutValue(Fn fn) const {
+        if (!layout) return;
+        for (uint32_t s = 0; s < layout->names.size(); ++s) {
+            if ((layoutPresent >> s) & 1u) fn(layout->names[s], layout->isBool(s), layoutValues[s]);
+        }
+    }
+
+    // Visit every float-vector param as (name, values)
+    template <typename Fn>
+    void forEachFloatVector(Fn fn) const {
+        const StringInterner& interner = StringInterner::instance();
+        for (const ParamSlot& slot : params) {
+            if (slot.kind == ParamKind::FloatVector) fn(interner.name(slot.key), floatVectorPool[slot.ref]);
+        }
     }
 
+    const string& scopeName() const { return *schemaScope; }
+
     // Runtime type detection, storage, validation/clamping (D. In-Place Validation)
     void storeParam(const string& key, const json& val, const string& ctx = "", const string& type = "") {
         if (!val.is_null() && !val.is_object()) { // Avoid storing nested objects as params
             ParamMeta meta;
             bool hasMeta = false;
-            if (paramSchema.count(key)) {
-                meta = paramSchema[key];
+            shared_ptr<const SchemaSnapshot> snap = SchemaRegistry::current();
+            const map<string, ParamMeta>* schema = snap->scope(*schemaScope);
+            const ParamMeta* scoped = nullptr;
+            if (schema) {
+                auto it = schema->find(key);
+                if (it != schema->end()) scoped = &it->second;
+            }
+            if (scoped && !scoped->discovered) {
+                meta = *scoped;
                 hasMeta = true;
-            } else if (!type.empty() && registeredSchemas.count(type) && registeredSchemas[type].count(key)) {
-                meta = registeredSchemas[type][key];
+            } else if (const ParamMeta* registered = type.empty() ? nullptr : snap->registeredParam(type, key)) {
+                meta = *registered;
                 hasMeta = true;
             } else {
-                // Auto-discovery for new param
+                // Discovered keys are shared by every instance of the type, so each value keeps its own detected type
                 meta.paramType = val.is_number() ? "float" : val.is_boolean() ? "bool" : val.is_string() ? "string" : val.is_array() ? (val[0].is_string() ? "vector<string>" : "vector<float>") : "unknown";
-                paramSchema[key] = meta;
-                cerr << "[AutoDiscovery] New param '" << key << "' detected at " << ctx << ". Schema update suggested: Define displayName/units/required for type " << meta.paramType << endl;
+                if (!scoped) {
+                    // Auto-discovery for new param; a concurrent loader may have published it first
+                    ParamMeta discoveredMeta = meta;
+                    discoveredMeta.minVal = discoveredMeta.maxVal = 0.0f;
+                    discoveredMeta.discovered = true;
+                    SchemaRegistry::discover(*schemaScope, key, discoveredMeta);
+                }
+                // Every sighting reports; only the first in load order is kept, whichever loader published
+                diagOnce(DiagCode::NewParamDiscovered, *schemaScope + "." + key, ctx, key, meta.paramType);
             }
 
             // Type-specific storage with checks
@@ -323,50 +1158,53 @@ struct BaseParamStruct {
                 if (hasMeta && meta.minVal != meta.maxVal) {
                     v = max(meta.minVal, min(v, meta.maxVal)); // Clamp
                 }
-                floatParams[key] = v;
-                unifiedParams[key] = v;
+                setFloat(key, v);
             } else if (val.is_boolean() && meta.paramType == "bool") {
-                boolParams[key] = val.get<bool>();
-                unifiedParams[key] = val.get<bool>();
+                setBool(key, val.get<bool>());
             } else if (val.is_string() && meta.paramType == "string") {
-                stringParams[key] = val.get<string>();
-                unifiedParams[key] = val.get<string>();
+                setString(key, val.get<string>());
             } else if (val.is_array() && meta.paramType == "vector<float>") {
-                vector<float> vec = getFloatVec(val, ctx);
-                vectorParams[key] = vec;
-                unifiedParams[key] = vec;
+                setVector(key, getFloatVec(val, ctx));
             } else if (val.is_array() && meta.paramType == "vector<string>") {
-                vector<string> vec = getStringVec(val, ctx);
-                stringVectorParams[key] = vec;
-                unifiedParams[key] = vec;
+                setStringVector(key, getStringVec(val, ctx));
             } else if (val.is_number_integer() && meta.paramType == "float") {
                 float v = static_cast<float>(val.get<int>());
                 if (hasMeta && meta.minVal != meta.maxVal) {
                     v = max(meta.minVal, min(v, meta.maxVal));
                 }
-                floatParams[key] = v;
-                unifiedParams[key] = v;
+                setFloat(key, v);
             } else {
-                cerr << "[TypeError] Type mismatch for key '" << key << "' at " << ctx << ": expected " << meta.paramType << ", got " << val.type_name() << " value: " << val << "\n";
+                if (Diagnostics::instance().enabled(DiagCode::TypeMismatch))
+                    diag(DiagCode::TypeMismatch, ctx, key, "expected " + meta.paramType + ", got " + val.type_name() + " value: " + val.dump());
             }
         }
     }
 
-    // Serialize by looping over maps
+    // Serialize by walking the flat store
     json paramsToJson() const {
         json j;
-        for (const auto& [k, v] : floatParams) j[k] = v;
-        for (const auto& [k, v] : boolParams) j[k] = v;
-        for (const auto& [k, v] : stringParams) j[k] = v;
-        for (const auto& [k, v] : vectorParams) j[k] = v;
-        for (const auto& [k, v] : stringVectorParams) j[k] = v;
+        const StringInterner& interner = StringInterner::instance();
+        for (const ParamSlot& slot : params) {
+            const string& k = interner.name(slot.key);
+            switch (slot.kind) {
+                case ParamKind::Float: j[k] = slot.f; break;
+                case ParamKind::Bool: j[k] = slot.b; break;
+                case ParamKind::String: j[k] = stringPool[slot.ref]; break;
+                case ParamKind::FloatVector: j[k] = floatVectorPool[slot.ref]; break;
+                case ParamKind::StringVector: j[k] = stringVectorPool[slot.ref]; break;
+            }
+        }
+        forEachLayoutValue([&](const string& name, bool isBool, float v) {
+            if (isBool) j[name] = v != 0.0f;
+            else j[name] = v;
+        });
         return j;
     }
 
     // Load params by looping over JSON keys with strict checks and flagging
     void paramsFromJson(const json& j_obj, const string& type = "") {
         if (!j_obj.is_object()) {
-            cerr << "[TypeError] Expected object for paramsFromJson, got " << j_obj.type_name() << endl;
+            diag(DiagCode::ExpectedObject, "paramsFromJson", "object", j_obj.type_name());
             return;
         }
         set<string> handledKeys;
@@ -382,79 +1220,140 @@ struct BaseParamStruct {
             storeParam(key, val, type + "." + key, type);
             handledKeys.insert(key);
         }
+        // Keys discovered above may still be pending in a load batch; they would count as unknown here anyway
+        static const map<string, ParamMeta> noSchema;
+        shared_ptr<const SchemaSnapshot> snap = SchemaRegistry::current();
+        const map<string, ParamMeta>* scopedSchema = snap->scope(*schemaScope);
+        const map<string, ParamMeta>& schema = scopedSchema ? *scopedSchema : noSchema;
         // Flag unhandled (unused in JSON but expected in schema)
-        for (const auto& [schemaKey, meta] : paramSchema) {
+        for (const auto& [schemaKey, meta] : schema) {
             if (handledKeys.find(schemaKey) == handledKeys.end() && meta.required) {
-                cerr << "[Warning] Missing required param '" << schemaKey << "' in " << type << ". Defaulting if possible." << endl;
+                diag(DiagCode::MissingRequired, type, schemaKey);
                 // Auto-complete default based on type
-                if (meta.paramType == "float") floatParams[schemaKey] = 0.0f;
-                else if (meta.paramType == "bool") boolParams[schemaKey] = false;
-                else if (meta.paramType == "string") stringParams[schemaKey] = "";
+                if (meta.paramType == "float") setFloat(schemaKey, 0.0f);
+                else if (meta.paramType == "bool") setBool(schemaKey, false);
+                else if (meta.paramType == "string") setString(schemaKey, "");
                 // ... extend for other types
             }
         }
-        // Flag unknown (in JSON but not in schema)
+        // Flag unknown (in JSON but not in schema). A discovered entry only counts as known if the
+        // discovery came earlier in load order, which diagnostics settle at flush for parallel loads.
         for (const auto& [jsonKey, _] : j_obj.items()) {
-            if (handledKeys.find(jsonKey) != handledKeys.end() && paramSchema.find(jsonKey) == paramSchema.end() && jsonKey != "type") {
-                cerr << "[Warning] Unknown field '" << jsonKey << "' in " << type << ". Stored but suggest schema update." << endl;
+            if (handledKeys.find(jsonKey) == handledKeys.end() || jsonKey == "type") continue;
+            auto known = schema.find(jsonKey);
+            if (known == schema.end() || known->second.discovered) {
+                diagUnless(DiagCode::UnknownField, *schemaScope + "." + jsonKey, type, jsonKey);
             }
         }
     }
 
-    // E. Automated Parameter Discovery
+    // E. Automated Parameter Discovery (grouped by type, alphabetical within each type)
     vector<string> getAllParamKeys() const {
+        const StringInterner& interner = StringInterner::instance();
+        vector<pair<ParamKind, string>> named;
+        named.reserve(params.size());
+        for (const ParamSlot& slot : params) named.emplace_back(slot.kind, interner.name(slot.key));
+        forEachLayoutValue([&](const string& name, bool isBool, float) {
+            named.emplace_back(isBool ? ParamKind::Bool : ParamKind::Float, name);
+        });
+        sort(named.begin(), named.end());
         vector<string> keys;
-        for (const auto& [k, _] : floatParams) keys.push_back(k);
-        for (const auto& [k, _] : boolParams) keys.push_back(k);
-        for (const auto& [k, _] : stringParams) keys.push_back(k);
-        for (const auto& [k, _] : vectorParams) keys.push_back(k);
-        for (const auto& [k, _] : stringVectorParams) keys.push_back(k);
+        keys.reserve(named.size());
+        for (auto& [kind, k] : named) keys.push_back(std::move(k));
         return keys;
     }
     
 
     // Schema loader (from JSON or code), now versioned
+    // The whole schema is parsed first and published as one new snapshot (hot reload safe)
     void loadSchema(const json& j_schema) {
         if (j_schema.is_object()) {
-            if (j_schema.contains("version") && j_schema["version"].is_string()) {
-                schemaVersion = j_schema["version"].get<string>();
-            }
+            map<string, ParamMeta> entries;
             for (auto& [key, meta_json] : j_schema.items()) {
                 if (key == "version") continue;
                 if (meta_json.is_object()) {
-                    ParamMeta meta;
-                    meta.from_json(meta_json);
-                    paramSchema[key] = meta;
+                    entries[key].from_json(meta_json);
                 } else {
-                    cerr << "[TypeError] Schema entry for " << key << " is not an object: " << meta_json << endl;
+                    diag(DiagCode::InvalidEntry, "schema", key, meta_json);
                 }
             }
+            SchemaRegistry::update([&](SchemaSnapshot& next) {
+                if (j_schema.contains("version") && j_schema["version"].is_string()) {
+                    next.version = j_schema["version"].get<string>();
+                }
+                for (auto& [key, meta] : entries) next.scoped[*schemaScope][key] = meta;
+                return true;
+            });
         } else {
-            cerr << "[TypeError] Schema is not an object: " << j_schema << endl;
+            diag(DiagCode::ExpectedObject, "schema", "object", j_schema.type_name());
         }
     }
 
     json schemaToJson() const {
         json j;
-        for (const auto& [key, meta] : paramSchema) {
-            j[key] = meta.to_json();
+        shared_ptr<const SchemaSnapshot> snap = SchemaRegistry::current();
+        if (const map<string, ParamMeta>* schema = snap->scope(*schemaScope)) {
+            for (const auto& [key, meta] : *schema) {
+                j[key] = meta.to_json();
+            }
         }
-        j["version"] = schemaVersion;
+        j["version"] = snap->version;
         return j;
     }
-};
 
-// Static registry init
-map<string, map<string, ParamMeta>> BaseParamStruct::registeredSchemas;
-string BaseParamStruct::schemaVersion = "1.1"; // Initial version
+private:
+    const string* schemaScope; // Interned scope name ("oscillator", "fx", ...) in the registry's per-type schemas
+
+    // Layout slot holding `key` with the requested kind (float or bool), if this struct has one
+    optional<uint32_t> layoutSlot(ParamKey key, bool wantBool) const {
+        if (!layout) return nullopt;
+        optional<uint32_t> s = layout->slotOf(key);
+        if (!s || layout->isBool(*s) != wantBool) return nullopt;
+        return s;
+    }
+
+    const ParamSlot* findSlot(ParamKey key, ParamKind kind) const {
+        auto it = lower_bound(params.begin(), params.end(), key,
+                              [](const ParamSlot& slot, ParamKey k) { return slot.key < k; });
+        return (it != params.end() && it->key == key && it->kind == kind) ? &*it : nullptr;
+    }
+
+    const ParamSlot* findSlot(const string& key, ParamKind kind) const {
+        optional<ParamKey> id = StringInterner::instance().find(key);
+        return id ? findSlot(*id, kind) : nullptr;
+    }
+
+    // Slot for key holding `kind`, inserted in key order or retyped in place; heap kinds get a pool entry
+    ParamSlot& slotFor(ParamKey key, ParamKind kind) {
+        auto it = lower_bound(params.begin(), params.end(), key,
+                              [](const ParamSlot& slot, ParamKey k) { return slot.key < k; });
+        if (it != params.end() && it->key == key && it->kind == kind) return *it;
+        if (it == params.end() || it->key != key) {
+            it = params.insert(it, ParamSlot{});
+            it->key = key;
+        }
+        // A retyped heap value leaves its old pool entry unused; retyping only happens on conflicting merges
+        it->kind = kind;
+        switch (kind) {
+            case ParamKind::Float: it->f = 0.0f; break;
+            case ParamKind::Bool: it->b = false; break;
+            case ParamKind::String: it->ref = static_cast<uint32_t>(stringPool.size()); stringPool.emplace_back(); break;
+            case ParamKind::FloatVector: it->ref = static_cast<uint32_t>(floatVectorPool.size()); floatVectorPool.emplace_back(); break;
+            case ParamKind::StringVector: it->ref = static_cast<uint32_t>(stringVectorPool.size()); stringVectorPool.emplace_back(); break;
+        }
+        return *it;
+    }
+};
 
 // Oscillator derived from BaseParamStruct
 struct Oscillator : public BaseParamStruct {
+    Oscillator() : BaseParamStruct("oscillator") {}
+
     void from_json(const json& j) {
         if (j.is_object()) {
             paramsFromJson(j);
         } else {
-            cerr << "[TypeError] Expected object for Oscillator, got " << j.type_name() << endl;
+            diag(DiagCode::ExpectedObject, "Oscillator", "object", j.type_name());
         }
     }
 
@@ -465,6 +1364,8 @@ struct Oscillator : public BaseParamStruct {
 
 // Envelope derived from BaseParamStruct
 struct Envelope : public BaseParamStruct {
+    Envelope() : BaseParamStruct("envelope") {}
+
     void from_json(const json& j) {
         if (j.is_object()) {
             paramsFromJson(j);
@@ -473,23 +1374,23 @@ struct Envelope : public BaseParamStruct {
             if (j.size() == 4) {
                 for (size_t i = 0; i < j.size(); ++i) {
                     if (j[i].is_number()) {
-                        floatParams[adsrKeys[i]] = j[i].get<float>();
+                        setFloat(adsrKeys[i], j[i].get<float>());
                     }
                 }
-                cerr << "[AutoInfer] Compacted ADSR array detected—mapped to attack/decay/sustain/release." << endl;
+                diag(DiagCode::EnvelopeInferred, "Envelope", "attack/decay/sustain/release", "ADSR");
             } else if (j.size() == 6) { // ADHSR
                 vector<string> adhshrKeys = {"attack", "decay", "hold", "sustain", "release", "delay"};
                 for (size_t i = 0; i < j.size(); ++i) {
                     if (j[i].is_number()) {
-                        floatParams[adhshrKeys[i]] = j[i].get<float>();
+                        setFloat(adhshrKeys[i], j[i].get<float>());
                     }
                 }
-                cerr << "[AutoInfer] Compacted ADHSR array detected—mapped to attack/decay/hold/sustain/release/delay." << endl;
+                diag(DiagCode::EnvelopeInferred, "Envelope", "attack/decay/hold/sustain/release/delay", "ADHSR");
             } else {
-                cerr << "[TypeError] Unknown envelope array length: " << j.size() << "—skipped." << endl;
+                diag(DiagCode::InvalidEntry, "Envelope", "array length", to_string(j.size()));
             }
         } else {
-            cerr << "[TypeError] Expected object or array for Envelope, got " << j.type_name() << endl;
+            diag(DiagCode::ExpectedObject, "Envelope", "object or array", j.type_name());
         }
     }
 
@@ -500,11 +1401,13 @@ struct Envelope : public BaseParamStruct {
 
 // Filter derived from BaseParamStruct
 struct Filter : public BaseParamStruct {
+    Filter() : BaseParamStruct("filter") {}
+
     void from_json(const json& j) {
         if (j.is_object()) {
             paramsFromJson(j);
         } else {
-            cerr << "[TypeError] Expected object for Filter, got " << j.type_name() << endl;
+            diag(DiagCode::ExpectedObject, "Filter", "object", j.type_name());
         }
     }
 
@@ -517,17 +1420,20 @@ struct Filter : public BaseParamStruct {
 struct Fx : public BaseParamStruct {
     string type;
 
+    Fx() : BaseParamStruct("fx") {}
+
     void from_json(const json& j) {
         if (j.is_object()) {
             if (j.contains("type") && j["type"].is_string()) {
                 type = j["type"].get<string>();
             } else {
                 type = "none";
-                cerr << "[TypeError] Missing or non-string 'type' in Fx: " << j << endl;
+                diag(DiagCode::InvalidEntry, "Fx", "type", j);
             }
+            useLayout(type); // Registered params go to fixed slots
             paramsFromJson(j, type); // Pass type for schema lookup
         } else {
-            cerr << "[TypeError] Expected object for Fx, got " << j.type_name() << endl;
+            diag(DiagCode::ExpectedObject, "Fx", "object", j.type_name());
         }
     }
 
@@ -538,17 +1444,81 @@ struct Fx : public BaseParamStruct {
     }
 };
 
-// Metadata remains as-is
-struct Metadata {
-    string description, namingConvention, version;
+// FxBatch: structure-of-arrays view over many Fx of one registered type. Each layout slot becomes
+// one contiguous column, so batch passes run over plain float arrays with no per-key lookups.
+struct FxBatch {
+    shared_ptr<const ParamLayout> layout;
+    vector<Fx*> members;
+    vector<vector<float>> columns; // [slot][member]
+    vector<uint64_t> present;      // [member] presence mask
+
+    static FxBatch gather(const string& type, const vector<Fx*>& candidates) {
+        FxBatch batch;
+        batch.layout = BaseParamStruct::findLayout(type);
+        if (!batch.layout) return batch;
+        for (Fx* fx : candidates) {
+            if (fx->layout == batch.layout) batch.members.push_back(fx);
+        }
+        batch.columns.assign(batch.layout->names.size(), vector<float>(batch.members.size(), 0.0f));
+        batch.present.resize(batch.members.size());
+        for (size_t m = 0; m < batch.members.size(); ++m) {
+            const Fx& fx = *batch.members[m];
+            for (size_t s = 0; s < batch.columns.size(); ++s) batch.columns[s][m] = fx.layoutValues[s];
+            batch.present[m] = fx.layoutPresent;
+        }
+        return batch;
+    }
 
-    void from_json(const json& j) {
-        if (j.is_object()) {
-            if (j.contains("description") && j["description"].is_string()) description = j["description"].get<string>();
-            if (j.contains("naming_convention") && j["naming_convention"].is_string()) namingConvention = j["naming_convention"].get<string>();
-            if (j.contains("version") && j["version"].is_string()) version = j["version"].get<string>();
-        } else {
-            cerr << "[TypeError] Expected object for Metadata, got " << j.type_name() << endl;
+    float* column(ParamHandle h) {
+        return (h.layout == layout.get() && h.layout) ? columns[h.slot].data() : nullptr;
+    }
+
+    // Mean of one slot over the members that set it (0 when none did)
+    float mean(ParamHandle h, size_t* count = nullptr) const {
+        if (h.layout != layout.get() || !h.layout) return 0.0f;
+        const vector<float>& col = columns[h.slot];
+        float sum = 0.0f;
+        size_t n = 0;
+        for (size_t m = 0; m < col.size(); ++m) {
+            if ((present[m] >> h.slot) & 1u) {
+                sum += col[m];
+                ++n;
+            }
+        }
+        if (count) *count = n;
+        return n ? sum / n : 0.0f;
+    }
+
+    // Clamp every slot column to its schema range in one pass per column
+    void clampToSchema() {
+        for (size_t s = 0; s < columns.size(); ++s) {
+            const ParamMeta& meta = layout->metas[s];
+            if (meta.minVal == meta.maxVal) continue;
+            for (float& v : columns[s]) v = max(meta.minVal, min(v, meta.maxVal));
+        }
+    }
+
+    // Write column values back into the member structs
+    void scatter() const {
+        for (size_t m = 0; m < members.size(); ++m) {
+            Fx& fx = *members[m];
+            for (size_t s = 0; s < columns.size(); ++s) fx.layoutValues[s] = columns[s][m];
+            fx.layoutPresent = present[m];
+        }
+    }
+};
+
+// Metadata remains as-is
+struct Metadata {
+    string description, namingConvention, version;
+
+    void from_json(const json& j) {
+        if (j.is_object()) {
+            if (j.contains("description") && j["description"].is_string()) description = j["description"].get<string>();
+            if (j.contains("naming_convention") && j["naming_convention"].is_string()) namingConvention = j["naming_convention"].get<string>();
+            if (j.contains("version") && j["version"].is_string()) version = j["version"].get<string>();
+        } else {
+            diag(DiagCode::ExpectedObject, "Metadata", "object", j.type_name());
         }
     }
 
@@ -585,16 +1555,16 @@ struct GroupConfig {
                     if (fxItem.is_object()) {
                         Fx fxStruct;
                         fxStruct.from_json(fxItem);
-                        fx.push_back(fxStruct);
+                        fx.emplace_back(move(fxStruct));
                     } else {
-                        cerr << "[TypeError] Fx item is not an object: " << fxItem << endl;
+                        diag(DiagCode::InvalidEntry, "GroupConfig", "fx", fxItem);
                     }
                 }
             }
             if (j.contains("sound_characteristics") && j["sound_characteristics"].is_object()) soundCharacteristics.from_json(j["sound_characteristics"]);
             if (j.contains("topological_metadata") && j["topological_metadata"].is_object()) topologicalMetadata.from_json(j["topological_metadata"]);
         } else {
-            cerr << "[TypeError] Expected object for GroupConfig, got " << j.type_name() << endl;
+            diag(DiagCode::ExpectedObject, "GroupConfig", "object", j.type_name());
         }
     }
 
@@ -620,13 +1590,15 @@ struct GuitarParams : public BaseParamStruct {
     SoundCharacteristics soundCharacteristics;
     TopologicalMetadata topologicalMetadata;
 
+    GuitarParams() : BaseParamStruct("guitarParams") {}
+
     void from_json(const json& j) {
         if (j.is_object()) {
             paramsFromJson(j);
             if (j.contains("soundCharacteristics") && j["soundCharacteristics"].is_object()) soundCharacteristics.from_json(j["soundCharacteristics"]);
             if (j.contains("topologicalMetadata") && j["topologicalMetadata"].is_object()) topologicalMetadata.from_json(j["topologicalMetadata"]);
         } else {
-            cerr << "[TypeError] Expected object for GuitarParams, got " << j.type_name() << endl;
+            diag(DiagCode::ExpectedObject, "GuitarParams", "object", j.type_name());
         }
     }
 
@@ -638,12 +1610,300 @@ struct GuitarParams : public BaseParamStruct {
     }
 };
 
+// Process-wide heap counter for measurement builds only (-DCOUNT_HEAP_ALLOCATIONS): every operator new
+// then goes through it, so the allocation report also sees string payloads and param side pools and can
+// be compared across versions. Normal builds keep the default allocator and report the config pool only.
+#ifdef COUNT_HEAP_ALLOCATIONS
+struct HeapStats {
+    static constexpr bool enabled = true;
+    static inline atomic<size_t> allocations{0};
+    static inline atomic<size_t> bytes{0};
+};
+
+void* operator new(size_t size) {
+    HeapStats::allocations.fetch_add(1, memory_order_relaxed);
+    HeapStats::bytes.fetch_add(size, memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+
+// Kept out of line: inlined, GCC would see free() applied to the result of operator new and warn
+[[gnu::noinline]] void operator delete(void* p) noexcept { free(p); }
+[[gnu::noinline]] void operator delete(void* p, size_t) noexcept { free(p); }
+#else
+struct HeapStats {
+    static constexpr bool enabled = false;
+    static inline atomic<size_t> allocations{0};
+    static inline atomic<size_t> bytes{0};
+};
+#endif
+
+// memory_resource decorator that counts what passes through it (allocation calls and bytes)
+class CountingResource : public pmr::memory_resource {
+public:
+    explicit CountingResource(pmr::memory_resource* upstream) : upstream(upstream) {}
+
+    size_t allocations() const { return allocCount.load(memory_order_relaxed); }
+    size_t bytes() const { return allocBytes.load(memory_order_relaxed); }
+
+private:
+    pmr::memory_resource* upstream;
+    atomic<size_t> allocCount{0};
+    atomic<size_t> allocBytes{0};
+
+    void* do_allocate(size_t size, size_t alignment) override {
+        allocCount.fetch_add(1, memory_order_relaxed);
+        allocBytes.fetch_add(size, memory_order_relaxed);
+        return upstream->allocate(size, alignment);
+    }
+
+    void do_deallocate(void* p, size_t size, size_t alignment) override {
+        upstream->deallocate(p, size, alignment);
+    }
+
+    bool do_is_equal(const pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+// On-disk encodings for saveConfig: indented JSON (the historical format), single-line JSON, or CBOR
+enum class SaveFormat : uint8_t { Pretty, Compact, Cbor };
+
+inline optional<SaveFormat> parseSaveFormat(const string& name) {
+    if (name == "pretty") return SaveFormat::Pretty;
+    if (name == "compact") return SaveFormat::Compact;
+    if (name == "cbor") return SaveFormat::Cbor;
+    return nullopt;
+}
+
+/**
+ * Event-style JSON/CBOR writer over a buffered ostream. Containers are opened and closed as the
+ * caller walks its structs; only leaves are passed as json values. Pretty and compact output are
+ * byte-identical to json::dump(4) / json::dump() of the equivalent tree as long as object keys are
+ * emitted in sorted order. CBOR uses indefinite-length maps and arrays so nothing is counted ahead.
+ */
+class ConfigWriter {
+public:
+    static constexpr size_t FLUSH_THRESHOLD = 64 * 1024;
+
+    ConfigWriter(ostream& out, SaveFormat format)
+        : out(out), format(format) {
+        buffer.reserve(FLUSH_THRESHOLD + 4096);
+    }
+    ~ConfigWriter() { flush(); }
+
+    void beginObject() { open(0xBF, '{'); }
+    void endObject() { close('}'); }
+    void beginArray() { open(0x9F, '['); }
+    void endArray() { close(']'); }
+
+    void key(const string& name) {
+        if (format == SaveFormat::Cbor) {
+            cborHeader(3, name.size());
+            buffer += name;
+            return;
+        }
+        separate();
+        buffer += json(name).dump();
+        buffer += (format == SaveFormat::Pretty) ? ": " : ":";
+        afterKey = true;
+    }
+
+    // Scalar or small subtree, written in one piece
+    void value(const json& leaf) {
+        if (format == SaveFormat::Cbor) {
+            vector<uint8_t> bytes = json::to_cbor(leaf);
+            buffer.append(bytes.begin(), bytes.end());
+        } else if (format == SaveFormat::Pretty) {
+            separate();
+            // dump() indents from column 0; shift every continuation line to the current depth
+            string text = leaf.dump(INDENT);
+            size_t start = 0;
+            for (size_t nl = text.find('\n'); nl != string::npos; nl = text.find('\n', start)) {
+                buffer.append(text, start, nl + 1 - start);
+                buffer.append(depth() * INDENT, ' ');
+                start = nl + 1;
+            }
+            buffer.append(text, start, string::npos);
+        } else {
+            separate();
+            buffer += leaf.dump();
+        }
+        maybeFlush();
+    }
+
+    void field(const string& name, const json& leaf) {
+        key(name);
+        value(leaf);
+    }
+
+    void flush() {
+        if (buffer.empty()) return;
+        out.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+        written += buffer.size();
+        buffer.clear();
+    }
+
+    size_t bytesWritten() const { return written + buffer.size(); }
+
+private:
+    static constexpr unsigned INDENT = 4;
+
+    ostream& out;
+    SaveFormat format;
+    string buffer;
+    vector<bool> hasEntries; // One per open container
+    bool afterKey = false;
+    size_t written = 0;
+
+    unsigned depth() const { return static_cast<unsigned>(hasEntries.size()); }
+
+    // Comma and line break before a container entry; nothing right after a key
+    void separate() {
+        if (afterKey) {
+            afterKey = false;
+            return;
+        }
+        if (hasEntries.empty()) return;
+        if (hasEntries.back()) buffer += ',';
+        hasEntries.back() = true;
+        if (format == SaveFormat::Pretty) {
+            buffer += '\n';
+            buffer.append(depth() * INDENT, ' ');
+        }
+    }
+
+    void open(uint8_t cborMarker, char bracket) {
+        if (format == SaveFormat::Cbor) {
+            buffer += static_cast<char>(cborMarker);
+        } else {
+            separate();
+            buffer += bracket;
+        }
+        hasEntries.push_back(false);
+    }
+
+    void close(char bracket) {
+        bool nonEmpty = hasEntries.back();
+        hasEntries.pop_back();
+        if (format == SaveFormat::Cbor) {
+            buffer += static_cast<char>(0xFF);
+        } else {
+            if (format == SaveFormat::Pretty && nonEmpty) {
+                buffer += '\n';
+                buffer.append(depth() * INDENT, ' ');
+            }
+            buffer += bracket;
+        }
+        maybeFlush();
+    }
+
+    void cborHeader(uint8_t major, uint64_t length) {
+        uint8_t type = static_cast<uint8_t>(major << 5);
+        int extra = length < 24 ? 0 : length <= 0xFF ? 1 : length <= 0xFFFF ? 2 : length <= 0xFFFFFFFFu ? 4 : 8;
+        if (extra == 0) {
+            buffer += static_cast<char>(type | length);
+            return;
+        }
+        buffer += static_cast<char>(type | (extra == 1 ? 24 : extra == 2 ? 25 : extra == 4 ? 26 : 27));
+        for (int shift = (extra - 1) * 8; shift >= 0; shift -= 8)
+            buffer += static_cast<char>((length >> shift) & 0xFF);
+    }
+
+    void maybeFlush() {
+        if (buffer.size() >= FLUSH_THRESHOLD) flush();
+    }
+};
+
+/**
+ * ADSR ranges of one config in fixed slots: a row per source context, a column per envelope stage,
+ * min and max in separate arrays so a per-stage multiplier is one flat pass. `present` has bit
+ * slot(context, stage) set for each range the JSON defined; absent slots read as 0.
+ */
+struct AdsrTable {
+    enum Context : uint8_t { Osc, Group, Mood, Synth, CONTEXT_COUNT };
+    enum Stage : uint8_t { Delay, Attack, Hold, Decay, Sustain, Release, STAGE_COUNT };
+    static constexpr size_t SLOT_COUNT = CONTEXT_COUNT * STAGE_COUNT;
+    static constexpr array<const char*, CONTEXT_COUNT> CONTEXT_NAMES = {"osc", "group", "mood", "synth"};
+    static constexpr array<const char*, STAGE_COUNT> STAGE_NAMES = {"delay", "attack", "hold", "decay", "sustain", "release"};
+    // The four stages moods and synth sections define (and the effective-param rows carry)
+    static constexpr array<Stage, 4> ENVELOPE_STAGES = {Attack, Decay, Sustain, Release};
+    // Name order, so the JSON views match the old nested maps key for key
+    static constexpr array<Context, CONTEXT_COUNT> CONTEXTS_BY_NAME = {Group, Mood, Osc, Synth};
+    static constexpr array<Stage, STAGE_COUNT> STAGES_BY_NAME = {Attack, Decay, Delay, Hold, Release, Sustain};
+
+    alignas(32) array<float, SLOT_COUNT> lo{}, hi{};
+    uint32_t present = 0;
+
+    static constexpr size_t slot(Context context, Stage stage) { return context * STAGE_COUNT + stage; }
+
+    bool has(Context context, Stage stage) const { return present >> slot(context, stage) & 1u; }
+    bool empty() const { return present == 0; }
+    bool hasContext(Context context) const {
+        return (present >> slot(context, Delay) & ((1u << STAGE_COUNT) - 1)) != 0;
+    }
+
+    Range get(Context context, Stage stage) const {
+        size_t i = slot(context, stage);
+        return {lo[i], hi[i]};
+    }
+
+    void set(Context context, Stage stage, const json& j) {
+        Range range;
+        range.from_json(j);
+        size_t i = slot(context, stage);
+        lo[i] = range.min;
+        hi[i] = range.max;
+        present |= 1u << i;
+    }
+
+    // Scale every context's range of each stage by mul[stage]; absent slots stay 0
+    void scale(const array<float, STAGE_COUNT>& mul) {
+        array<float, SLOT_COUNT> factors;
+        for (size_t i = 0; i < SLOT_COUNT; ++i) factors[i] = mul[i % STAGE_COUNT];
+        for (size_t i = 0; i < SLOT_COUNT; ++i) {
+            lo[i] *= factors[i];
+            hi[i] *= factors[i];
+        }
+    }
+
+    // Present ranges in (context, stage) name order
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (Context context : CONTEXTS_BY_NAME) {
+            for (Stage stage : STAGES_BY_NAME) {
+                if (has(context, stage)) fn(context, stage, get(context, stage));
+            }
+        }
+    }
+
+    // Compatibility view: {"<context>": {"<stage>": range}} for the present ranges, as the nested maps produced
+    json to_json() const {
+        json j = json::object();
+        forEach([&](Context context, Stage stage, const Range& range) {
+            j[CONTEXT_NAMES[context]][STAGE_NAMES[stage]] = range.to_json();
+        });
+        return j;
+    }
+};
+
 // SoundConfig updated (fixed "fxect" typo to "effects")
+// Allocator-aware: inside a pmr container (the queue's configs) its own maps draw from the same pool.
 struct SoundConfig {
+    using allocator_type = pmr::polymorphic_allocator<byte>;
+
+    SoundConfig() = default;
+    explicit SoundConfig(const allocator_type& alloc) : oscTypes(alloc), effects(alloc) {}
+    // Move-only: configs are built in place in the queue and never copied out
+    SoundConfig(SoundConfig&&) = default;
+    SoundConfig& operator=(SoundConfig&&) = default;
+    SoundConfig(const SoundConfig&) = delete;
+    SoundConfig& operator=(const SoundConfig&) = delete;
+
     string instrumentType;
-    map<string, vector<string>> oscTypes;
-    map<string, map<string, Range>> adsr;
-    vector<Fx> effects; // Fixed from "fxect"
+    pmr::map<string, pmr::vector<string>> oscTypes;
+    AdsrTable adsr;
+    pmr::vector<Fx> effects; // Fixed from "fxect"
     bool useDynamicGate = false;
     float gateThreshold = 0.0f, gateDecaySec = 0.0f;
     string emotion;
@@ -652,56 +1912,501 @@ struct SoundConfig {
     SoundCharacteristics soundCharacteristics;
     TopologicalMetadata topologicalMetadata;
 
+    // The one field list behind to_json() and write(), in key order: emit(name, member) per field
+    template <typename Emit>
+    void forEachField(Emit&& emit) const {
+        if (!adsr.empty()) emit("adsr", adsr);
+        emit("effects", effects);
+        emit("emotion", emotion);
+        emit("gateDecaySec", gateDecaySec);
+        emit("gateThreshold", gateThreshold);
+        emit("guitarParams", guitarParams);
+        emit("instrumentType", instrumentType);
+        emit("oscTypes", oscTypes);
+        emit("soundCharacteristics", soundCharacteristics);
+        emit("topologicalMetadata", topologicalMetadata);
+        emit("topology", topology);
+        emit("useDynamicGate", useDynamicGate);
+    }
+
     json to_json() const {
-        json j;
-        j["instrumentType"] = instrumentType;
-        j["oscTypes"] = oscTypes;
-        for (const auto& [context, params] : adsr) {
-            for (const auto& [param, range] : params) {
-                j["adsr"][context][param] = range.to_json();
-            }
-        }
-        json fxArr = json::array();
-        for (const auto& fx : effects) {
-            fxArr.push_back(fx.to_json());
-        }
-        j["effects"] = fxArr; // Fixed from "fxect"
-        j["useDynamicGate"] = useDynamicGate;
-        j["gateThreshold"] = gateThreshold;
-        j["gateDecaySec"] = gateDecaySec;
-        j["emotion"] = emotion;
-        j["topology"] = topology;
-        j["guitarParams"] = guitarParams.to_json();
-        j["soundCharacteristics"] = soundCharacteristics.to_json();
-        j["topologicalMetadata"] = topologicalMetadata.to_json();
+        json j = json::object();
+        forEachField([&](const char* name, const auto& member) { j[name] = fieldJson(member); });
         return j;
     }
+
+    // Same document as to_json(), streamed straight from the members
+    void write(ConfigWriter& w) const {
+        w.beginObject();
+        forEachField([&](const char* name, const auto& member) {
+            w.key(name);
+            writeField(w, member);
+        });
+        w.endObject();
+    }
+
+private:
+    template <typename T, typename = void>
+    struct HasToJson : false_type {};
+    template <typename T>
+    struct HasToJson<T, void_t<decltype(declval<const T&>().to_json())>> : true_type {};
+
+    template <typename T>
+    static json fieldJson(const T& member) {
+        if constexpr (is_same_v<T, pmr::vector<Fx>>) {
+            json fxArr = json::array();
+            for (const auto& fx : member) fxArr.push_back(fx.to_json());
+            return fxArr;
+        } else if constexpr (HasToJson<T>::value) {
+            return member.to_json();
+        } else {
+            return member;
+        }
+    }
+
+    // Containers are streamed entry by entry; every other field is one value
+    template <typename T>
+    static void writeField(ConfigWriter& w, const T& member) {
+        if constexpr (is_same_v<T, AdsrTable>) {
+            w.beginObject();
+            for (AdsrTable::Context context : AdsrTable::CONTEXTS_BY_NAME) {
+                if (!member.hasContext(context)) continue;
+                w.key(AdsrTable::CONTEXT_NAMES[context]);
+                w.beginObject();
+                for (AdsrTable::Stage stage : AdsrTable::STAGES_BY_NAME) {
+                    if (member.has(context, stage)) w.field(AdsrTable::STAGE_NAMES[stage], member.get(context, stage).to_json());
+                }
+                w.endObject();
+            }
+            w.endObject();
+        } else if constexpr (is_same_v<T, pmr::vector<Fx>>) {
+            w.beginArray();
+            for (const auto& fx : member) w.value(fx.to_json());
+            w.endArray();
+        } else if constexpr (is_same_v<T, pmr::map<string, pmr::vector<string>>>) {
+            w.beginObject();
+            for (const auto& [osc, types] : member) w.field(osc, types);
+            w.endObject();
+        } else {
+            w.value(fieldJson(member));
+        }
+    }
 };
 
-// Alias mapping for ambiguous fields (e.g., "adsr" -> "envelope")
-map<string, string> fieldAliases = {
-    {"adsr", "envelope"},
-    {"osc", "oscillator"},
-    {"effects", "fx"}
-    // Add more as needed
+// One resolved (config, section) pair for the renderer: every column a fixed float, one cache line per row
+struct alignas(64) EffectiveParamRow {
+    enum Stage : uint8_t { Attack, Decay, Sustain, Release, STAGE_COUNT };
+    static constexpr uint32_t DYNAMIC_GATE = 1u << STAGE_COUNT; // Flag bit after the per-stage present bits
+
+    float stageMin[STAGE_COUNT] = {};
+    float stageMax[STAGE_COUNT] = {};
+    float gateThreshold = 0.0f;
+    float gateDecaySec = 0.0f;
+    float layerGain = 1.0f;
+    uint32_t flags = 0; // Bit per stage that was defined in some context, plus DYNAMIC_GATE
+    uint32_t configId = 0;
+    uint32_t sectionId = 0;
+
+    bool hasStage(Stage stage) const { return (flags >> stage) & 1u; }
+    bool dynamicGate() const { return flags & DYNAMIC_GATE; }
+};
+static_assert(sizeof(EffectiveParamRow) == 64, "EffectiveParamRow must stay one cache line");
+
+/**
+ * Flat table of effective parameters, one row per (config, section) named in structure.json.
+ * Config and section IDs are dense and fixed by reset(); a configs x sections index array, sized once
+ * there, maps a pair to its row in O(1).
+ */
+class EffectiveParamTable {
+public:
+    static constexpr uint32_t NO_ROW = numeric_limits<uint32_t>::max();
+
+    // Start over with these configs and sections (names compare case-insensitively); rows are added after
+    void reset(vector<const string*> configKeys, const vector<string>& sectionNames) {
+        configs = move(configKeys);
+        configIds.clear();
+        for (uint32_t id = 0; id < configs.size(); ++id) configIds.emplace(*configs[id], id);
+        sections.clear();
+        sectionIds.clear();
+        for (const string& name : sectionNames) {
+            if (sectionIds.emplace(lower(name), static_cast<uint32_t>(sections.size())).second) sections.push_back(name);
+        }
+        rows.clear();
+        index.assign(configs.size() * sections.size(), NO_ROW);
+    }
+
+    // New row for the pair, or nullptr if the pair already has one
+    EffectiveParamRow* addRow(uint32_t configId, uint32_t sectionId) {
+        uint32_t& slot = index[static_cast<size_t>(configId) * sections.size() + sectionId];
+        if (slot != NO_ROW) return nullptr;
+        slot = static_cast<uint32_t>(rows.size());
+        EffectiveParamRow& r = rows.emplace_back();
+        r.configId = configId;
+        r.sectionId = sectionId;
+        return &r;
+    }
+
+    const EffectiveParamRow* find(uint32_t configId, uint32_t sectionId) const {
+        if (configId >= configs.size() || sectionId >= sections.size()) return nullptr;
+        uint32_t slot = index[static_cast<size_t>(configId) * sections.size() + sectionId];
+        return slot == NO_ROW ? nullptr : &rows[slot];
+    }
+
+    const EffectiveParamRow* find(const string& configKey, const string& section) const {
+        optional<uint32_t> c = configId(configKey), s = sectionId(section);
+        return c && s ? find(*c, *s) : nullptr;
+    }
+
+    optional<uint32_t> configId(const string& key) const {
+        auto it = configIds.find(key);
+        return it != configIds.end() ? optional<uint32_t>(it->second) : nullopt;
+    }
+
+    optional<uint32_t> sectionId(const string& name) const {
+        auto it = sectionIds.find(lower(name));
+        return it != sectionIds.end() ? optional<uint32_t>(it->second) : nullopt;
+    }
+
+    const vector<EffectiveParamRow>& allRows() const { return rows; }
+    const string& configKey(uint32_t id) const { return *configs.at(id); }
+    const string& sectionName(uint32_t id) const { return sections.at(id); }
+    size_t sectionCount() const { return sections.size(); }
+
+private:
+    vector<const string*> configs; // Points at the queue's config keys
+    unordered_map<string, uint32_t> configIds;
+    vector<string> sections;
+    unordered_map<string, uint32_t> sectionIds; // Keyed by lowercased name
+    vector<EffectiveParamRow> rows;
+    vector<uint32_t> index; // configs x sections -> row, NO_ROW where a pair has none
 };
 
-void resolveAliases(json& section, const string& contextName) {
-    if (!section.is_object()) return;
-    for (const auto& [alias, canonical] : fieldAliases) {
-        if (section.contains(alias) && !section.contains(canonical)) {
-            section[canonical] = section[alias];
-            section.erase(alias);
-            cerr << "[Mapping] Renamed alias '" << alias << "' to canonical '" << canonical << "' for context: " << contextName << endl;
+/**
+ * Gain balancing tables: a fixed base gain per layer, plus mood offsets and section factors in flat
+ * arrays. Each table numbers its own names densely, so an array holds exactly one float per name
+ * with an entry (1.0 for any other name). Offsets come from
+ * moods.json ("gainOffset") and factors from Synthesizer.json ("gainFactor"); the built-in values
+ * stand in for files that don't set them.
+ */
+class GainTables {
+public:
+    static constexpr size_t LAYER_COUNT = 6;
+    using GainId = uint32_t;
+    static constexpr GainId NO_ID = numeric_limits<GainId>::max();
+
+    static const array<string, LAYER_COUNT>& layerNames() {
+        static const array<string, LAYER_COUNT> names = {"background_texture", "ambient_pad", "supportive_harmony",
+                                                         "rhythmic_motion", "main_melodic", "lead_foreground"};
+        return names;
+    }
+
+    // Layer gains for many (mood, section) pairs, layer-major: at(combo, layer) = values[layer * combos + combo]
+    struct GainMatrix {
+        size_t combos = 0;
+        vector<float> values;
+
+        float at(size_t combo, size_t layer) const { return values[layer * combos + combo]; }
+        array<float, LAYER_COUNT> combo(size_t index) const {
+            array<float, LAYER_COUNT> out;
+            for (size_t layer = 0; layer < LAYER_COUNT; ++layer) out[layer] = at(index, layer);
+            return out;
         }
+    };
+
+    GainTables() {
+        setMoodOffset("calm", 0.8f);        // Softer overall
+        setMoodOffset("energetic", 1.2f);   // Boost
+        setSectionFactor("intro", 0.9f);    // Softer
+        setSectionFactor("chorus", 1.1f);   // Louder
+    }
+
+    void setMoodOffset(const string& mood, float offset) { set(moodOffsets, mood, offset); }
+    void setSectionFactor(const string& section, float factor) { set(sectionFactors, section, factor); }
+
+    // Dense ID of a mood or section name in its own table, NO_ID if it has no entry
+    GainId moodId(const string& mood) const { return idIn(moodOffsets, mood); }
+    GainId sectionId(const string& section) const { return idIn(sectionFactors, section); }
+
+    static optional<size_t> layerIndex(const string& layer) {
+        const auto& names = layerNames();
+        auto it = find(names.begin(), names.end(), layer);
+        return it != names.end() ? optional<size_t>(it - names.begin()) : nullopt;
+    }
+
+    float moodOffset(GainId mood) const { return lookup(moodOffsets, mood); }
+    float sectionFactor(GainId section) const { return lookup(sectionFactors, section); }
+
+    float gain(size_t layer, GainId mood, GainId section) const {
+        return BASE_GAINS[layer] * moodOffset(mood) * sectionFactor(section);
+    }
+
+    float gain(const string& layer, const string& mood, const string& section) const {
+        optional<size_t> index = layerIndex(layer);
+        return index ? gain(*index, moodId(mood), sectionId(section)) : 0.0f;
+    }
+
+    array<float, LAYER_COUNT> layerGains(GainId mood, GainId section) const {
+        array<float, LAYER_COUNT> out;
+        for (size_t layer = 0; layer < LAYER_COUNT; ++layer) out[layer] = gain(layer, mood, section);
+        return out;
     }
-    // Recurse for nested objects
-    for (auto& [key, val] : section.items()) {
-        if (val.is_object()) {
-            resolveAliases(val, contextName + "." + key);
+
+    /**
+     * Batch form for arrangement generation: the per-pair factors are gathered once, then each layer
+     * is a straight multiply over contiguous floats, which the compiler vectorizes.
+     */
+    GainMatrix gains(const vector<pair<GainId, GainId>>& combos) const {
+        GainMatrix matrix;
+        matrix.combos = combos.size();
+        vector<float> moods(combos.size()), sections(combos.size());
+        for (size_t i = 0; i < combos.size(); ++i) {
+            moods[i] = moodOffset(combos[i].first);
+            sections[i] = sectionFactor(combos[i].second);
+        }
+        matrix.values.resize(LAYER_COUNT * combos.size());
+        const float* m = moods.data();
+        const float* s = sections.data();
+        for (size_t layer = 0; layer < LAYER_COUNT; ++layer) {
+            float base = BASE_GAINS[layer];
+            float* out = matrix.values.data() + layer * combos.size();
+            for (size_t i = 0; i < combos.size(); ++i) out[i] = base * m[i] * s[i];
         }
+        return matrix;
     }
-}
+
+private:
+    static constexpr float BASE_GAINS[LAYER_COUNT] = {0.2f, 0.4f, 0.5f, 0.6f, 0.7f, 0.9f}; // Per layerNames()
+
+    struct Table {
+        unordered_map<string, GainId> ids; // Lowercased name -> index into values
+        vector<float> values;
+    };
+
+    Table moodOffsets;
+    Table sectionFactors;
+
+    static void set(Table& table, const string& name, float value) {
+        auto [it, inserted] = table.ids.try_emplace(lower(name), static_cast<GainId>(table.values.size()));
+        if (inserted) {
+            table.values.push_back(value);
+        } else {
+            table.values[it->second] = value;
+        }
+    }
+
+    static GainId idIn(const Table& table, const string& name) {
+        auto it = table.ids.find(lower(name));
+        return it != table.ids.end() ? it->second : NO_ID;
+    }
+
+    static float lookup(const Table& table, GainId id) {
+        return id < table.values.size() ? table.values[id] : 1.0f;
+    }
+};
+
+// Alias mapping for ambiguous fields (e.g., "adsr" -> "envelope"), extendable from a user aliases file
+class FieldAliases {
+public:
+    static FieldAliases& instance() {
+        static FieldAliases aliases;
+        return aliases;
+    }
+
+    const string* canonicalFor(const string& key) const {
+        auto it = aliases.find(key);
+        return it == aliases.end() ? nullptr : &it->second;
+    }
+
+    bool isCanonical(const string& key) const { return canonicals.count(key) > 0; }
+
+    void add(const string& alias, const string& canonical) {
+        if (alias == canonical) return;
+        aliases[alias] = canonical;
+        canonicals.insert(canonical);
+    }
+
+    // User aliases: a flat object {"alias": "canonical", ...}
+    bool load(const string& file) {
+        ifstream inFile(file);
+        if (!inFile) {
+            diag(DiagCode::FileNotOpened, file);
+            return false;
+        }
+        json j = json::parse(inFile, nullptr, false);
+        if (!j.is_object()) {
+            diag(DiagCode::ExpectedObject, file, "object", j.type_name());
+            return false;
+        }
+        for (const auto& [alias, canonical] : j.items()) {
+            if (canonical.is_string()) add(alias, canonical.get<string>());
+            else diag(DiagCode::InvalidEntry, file, alias, canonical);
+        }
+        return true;
+    }
+
+private:
+    unordered_map<string, string> aliases;
+    set<string> canonicals;
+
+    FieldAliases() {
+        add("adsr", "envelope");
+        add("osc", "oscillator");
+        add("effects", "fx");
+    }
+};
+
+/**
+ * SAX handler that builds the DOM and canonicalizes alias keys as they are parsed, but only inside the
+ * sections a loader names: objects reached along `sections` (object keys, "*" for any key, "[]" for any
+ * array element) and the objects nested in them. When an object holds both an alias and its canonical
+ * key, the canonical value wins in either order and the dropped alias is reported; an alias that comes
+ * after its canonical key is skipped without building its subtree.
+ */
+class AliasingSaxBuilder {
+public:
+    AliasingSaxBuilder(json& result, const std::string& source, const vector<std::string>& sections)
+        : result(result), source(source), sections(sections) {}
+
+    bool null() { return value(nullptr); }
+    bool boolean(bool val) { return value(val); }
+    bool number_integer(json::number_integer_t val) { return value(val); }
+    bool number_unsigned(json::number_unsigned_t val) { return value(val); }
+    bool number_float(json::number_float_t val, const std::string&) { return value(val); }
+    bool string(std::string& val) { return value(std::move(val)); }
+    bool binary(json::binary_t& val) { return value(json::binary(std::move(val))); }
+
+    bool start_object(size_t) { return open(json::object()); }
+    bool start_array(size_t) { return open(json::array()); }
+    bool end_object() { return close(); }
+    bool end_array() { return close(); }
+
+    bool key(std::string& val) {
+        if (skipping) return true;
+        Frame& frame = frames.back();
+        frame.key = val;
+        if (!frame.aliasing) return true;
+        const FieldAliases& aliases = FieldAliases::instance();
+        if (const std::string* canonical = aliases.canonicalFor(val)) {
+            if (frame.node->contains(*canonical)) {
+                diag(DiagCode::InvalidEntry, path(), val, "dropped, '" + *canonical + "' is also set");
+                skipNext = true;
+                return true;
+            }
+            diag(DiagCode::AliasRenamed, path(), val, *canonical);
+            frame.fromAlias.emplace_back(*canonical, val);
+            frame.key = *canonical;
+        } else if (aliases.isCanonical(val)) {
+            // The canonical key replaces a value an earlier alias put there
+            auto alias = find_if(frame.fromAlias.begin(), frame.fromAlias.end(), [&](const auto& entry) { return entry.first == val; });
+            if (alias != frame.fromAlias.end()) {
+                diag(DiagCode::InvalidEntry, path(), alias->second, "dropped, '" + val + "' is also set");
+                frame.node->erase(val);
+                frame.fromAlias.erase(alias);
+            }
+        }
+        return true;
+    }
+
+    // Rethrow with the concrete type, as json::parse would
+    bool parse_error(size_t, const std::string&, const json::exception& ex) {
+        if (const auto* parseError = dynamic_cast<const json::parse_error*>(&ex)) throw *parseError;
+        if (const auto* outOfRange = dynamic_cast<const json::out_of_range*>(&ex)) throw *outOfRange;
+        throw runtime_error(ex.what());
+    }
+
+private:
+    static constexpr size_t OFF_PATH = numeric_limits<size_t>::max();
+
+    struct Frame {
+        json* node;
+        std::string key;          // Current key in an object
+        size_t matched;           // Section path tokens matched to reach this container, or OFF_PATH
+        bool aliasing;            // Inside a section: alias keys are canonicalized here
+        vector<pair<std::string, std::string>> fromAlias; // (canonical, alias) keys set through an alias
+    };
+
+    json& result;
+    std::string source;
+    const vector<std::string>& sections;
+    vector<Frame> frames;
+    bool skipNext = false;  // The next value belongs to a dropped alias key
+    size_t skipping = 0;    // Nesting depth inside a dropped value
+
+    // Attach a finished value (or a new container) where the parser is, returning it in place
+    json* place(json&& val) {
+        if (frames.empty()) {
+            result = std::move(val);
+            return &result;
+        }
+        Frame& frame = frames.back();
+        if (frame.node->is_array()) {
+            frame.node->push_back(std::move(val));
+            return &frame.node->back();
+        }
+        json& slot = (*frame.node)[frame.key];
+        slot = std::move(val);
+        return &slot;
+    }
+
+    bool value(json&& val) {
+        if (skipping) return true;
+        if (skipNext) {
+            skipNext = false;
+            return true;
+        }
+        place(std::move(val));
+        return true;
+    }
+
+    bool open(json&& container) {
+        if (skipping || skipNext) {
+            skipNext = false;
+            ++skipping;
+            return true;
+        }
+        bool isObject = container.is_object();
+        size_t matched = 0;
+        bool aliasing = false;
+        if (!frames.empty()) {
+            const Frame& parent = frames.back();
+            bool parentIsArray = parent.node->is_array();
+            if (parent.matched < sections.size()) {
+                const std::string& token = sections[parent.matched];
+                bool matches = parentIsArray ? token == "[]" : (token == "*" || token == parent.key);
+                matched = matches ? parent.matched + 1 : OFF_PATH;
+            } else {
+                matched = OFF_PATH;
+            }
+            aliasing = isObject && ((parent.aliasing && !parentIsArray) || matched == sections.size());
+        }
+        json* node = place(std::move(container));
+        frames.push_back({node, "", matched, aliasing, {}});
+        return true;
+    }
+
+    bool close() {
+        if (skipping) {
+            --skipping;
+            return true;
+        }
+        frames.pop_back();
+        return true;
+    }
+
+    // Diagnostic context: source file plus the keys (and array positions) leading to the current object
+    std::string path() const {
+        std::string p = source + ":";
+        for (size_t i = 0; i + 1 < frames.size(); ++i) {
+            if (frames[i].node->is_array()) {
+                p += "[" + to_string(frames[i].node->size() - 1) + "]";
+            } else {
+                if (i > 0) p += ".";
+                p += frames[i].key;
+            }
+        }
+        return p;
+    }
+};
 
 // Semantic Keyword Database (SKD) as global json
 json skd = R"(
@@ -757,6 +2462,130 @@ json skd = R"(
 }
 )"_json;
 
+/**
+ * SKD compiled for lookup: an open-addressing table from every lowercased SKD key and alias to its
+ * postings (canonical entry, category, score, whether the term is an alias). Postings for a term are
+ * in SKD key order, so callers see matches in the same order the json walk produced them.
+ */
+class SkdIndex {
+public:
+    struct Posting {
+        uint32_t canonical;  // Index into canonicalNames (SKD key order)
+        int32_t category;    // Index into categoryNames, -1 when the entry has no string category
+        double score;
+        bool isAlias;
+    };
+
+    static shared_ptr<const SkdIndex> compile(const json& skdJson) {
+        auto index = make_shared<SkdIndex>();
+        unordered_map<string, vector<Posting>> byTerm;
+        vector<string> termOrder;
+        map<string, int32_t> categoryIds;
+        auto addPosting = [&](const string& term, const Posting& posting) {
+            auto [it, inserted] = byTerm.try_emplace(term);
+            if (inserted) termOrder.push_back(term);
+            vector<Posting>& list = it->second;
+            if (!list.empty() && list.back().canonical == posting.canonical) {
+                list.back().isAlias = list.back().isAlias && posting.isAlias; // Key match beats alias match
+                return;
+            }
+            list.push_back(posting);
+        };
+
+        for (const auto& [key, entry] : skdJson.items()) {
+            if (!entry.is_object()) continue;
+            Posting posting{static_cast<uint32_t>(index->canonicalNames.size()), -1, entry.value("score", 0.0), false};
+            if (entry.contains("category") && entry["category"].is_string()) {
+                string category = entry["category"].get<string>();
+                auto [it, inserted] = categoryIds.try_emplace(category, static_cast<int32_t>(index->categoryNames.size()));
+                if (inserted) index->categoryNames.push_back(category);
+                posting.category = it->second;
+            }
+            index->canonicalNames.push_back(key);
+            addPosting(lower(key), posting);
+            if (entry.contains("aliases")) {
+                posting.isAlias = true;
+                for (const string& alias : getStringVec(entry["aliases"], "skd." + key + ".aliases")) {
+                    addPosting(lower(alias), posting);
+                }
+            }
+        }
+
+        size_t capacity = 16;
+        while (capacity < termOrder.size() * 2) capacity <<= 1; // Load factor <= 0.5
+        index->buckets.assign(capacity, Bucket{});
+        index->mask = capacity - 1;
+        for (const string& term : termOrder) {
+            const vector<Posting>& list = byTerm[term];
+            uint64_t hash = hashTerm(term);
+            size_t slot = hash & index->mask;
+            while (index->buckets[slot].count != 0) slot = (slot + 1) & index->mask;
+            index->buckets[slot] = {hash, static_cast<uint32_t>(index->terms.size()),
+                                    static_cast<uint32_t>(index->postings.size()), static_cast<uint32_t>(list.size())};
+            index->terms.push_back(term);
+            index->postings.insert(index->postings.end(), list.begin(), list.end());
+        }
+        return index;
+    }
+
+    // Postings for an already-lowercased term; empty range when the term is not in the SKD
+    pair<const Posting*, const Posting*> lookup(string_view term) const {
+        uint64_t hash = hashTerm(term);
+        for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+            const Bucket& b = buckets[slot];
+            if (b.count == 0) return {nullptr, nullptr};
+            if (b.hash == hash && terms[b.term] == term) {
+                const Posting* first = postings.data() + b.first;
+                return {first, first + b.count};
+            }
+        }
+    }
+
+    // The entry whose own key is `term`, if any
+    const Posting* entry(string_view term) const {
+        auto [first, last] = lookup(term);
+        for (const Posting* p = first; p != last; ++p) {
+            if (!p->isAlias) return p;
+        }
+        return nullptr;
+    }
+
+    const string& canonicalName(uint32_t id) const { return canonicalNames[id]; }
+    const string& categoryName(int32_t id) const { return categoryNames[id]; }
+    size_t termCount() const { return terms.size(); }
+
+private:
+    struct Bucket {
+        uint64_t hash = 0;
+        uint32_t term = 0;
+        uint32_t first = 0;
+        uint32_t count = 0;  // 0 marks an empty bucket (every stored term has at least one posting)
+    };
+
+    vector<Bucket> buckets;
+    size_t mask = 0;
+    vector<string> terms;
+    vector<Posting> postings;
+    vector<string> canonicalNames;
+    vector<string> categoryNames;
+
+    static uint64_t hashTerm(string_view term) {
+        uint64_t h = 1469598103934665603ULL; // FNV-1a
+        for (unsigned char c : term) {
+            h ^= c;
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+};
+
+// Current compiled SKD; readers take a snapshot and loadSKD swaps in a new table atomically
+shared_ptr<const SkdIndex> skdIndex = SkdIndex::compile(skd);
+
+shared_ptr<const SkdIndex> currentSkdIndex() {
+    return atomic_load(&skdIndex);
+}
+
 void loadSKD(const string& file = "skd.json") {
     ifstream inFile(file);
     json loadedSKD;
@@ -764,45 +2593,33 @@ void loadSKD(const string& file = "skd.json") {
         inFile >> loadedSKD;
         if (loadedSKD.is_object()) {
             skd = loadedSKD;
-            cerr << "[Info] Loaded SKD from " << file << endl;
+            diag(DiagCode::SkdLoaded, file);
         } else {
-            cerr << "[TypeError] SKD file not an object—using hardcoded fallback." << endl;
+            diag(DiagCode::SkdFallback, file, "", "is not an object");
         }
     } else {
-        cerr << "[Warn] SKD file not found—using hardcoded fallback." << endl;
+        diag(DiagCode::SkdFallback, file, "", "not found");
     }
     // Validate SKD structure
     for (auto& [key, entry] : skd.items()) {
         if (!entry.is_object() || !entry.contains("category") || !entry["category"].is_string()) {
-            cerr << "[TypeError] Invalid SKD entry for '" << key << "': " << entry << endl;
+            diag(DiagCode::InvalidEntry, "skd", key, entry);
         }
     }
+    atomic_store(&skdIndex, SkdIndex::compile(skd));
 }
 
 // Group configs by category for narrowing (Step 2)
 map<string, vector<string>> groupByCategory(const vector<string>& userTags) {
+    shared_ptr<const SkdIndex> index = currentSkdIndex();
     map<string, vector<string>> groups;
     for (const string& tag : userTags) {
-        string ltag = lower(tag);
         bool matched = false;
-        for (auto& [skdKey, entry] : skd.items()) {
-            string lskd = lower(skdKey);
-            if (entry.is_object() && entry.contains("category") && entry["category"].is_string()) {
-                string cat = entry["category"].get<string>();
-                if (ltag == lskd) {
-                    groups[cat].push_back(skdKey);
-                    matched = true;
-                } else if (entry.contains("aliases") && entry["aliases"].is_array()) {
-                    vector<string> aliases = getStringVec(entry["aliases"]);
-                    for (const string& alias : aliases) {
-                        if (lower(alias) == ltag) {
-                            groups[cat].push_back(skdKey);
-                            matched = true;
-                            break;
-                        }
-                    }
-                }
-            }
+        auto [first, last] = index->lookup(lower(tag));
+        for (const SkdIndex::Posting* p = first; p != last; ++p) {
+            if (p->category < 0) continue;
+            groups[index->categoryName(p->category)].push_back(index->canonicalName(p->canonical));
+            matched = true;
         }
         if (!matched) {
             // Handle unrecognized (stub for now; expand later)
@@ -831,64 +2648,228 @@ map<string, vector<double>> keywordVectors = {
     // ... add for all SKD keys and aliases
 };
 
-// Function to compute semantic score for a config based on user tags
-double computeSemanticScore(const SoundConfig& cfg, const vector<string>& userTags, const string& mood = "", const string& synthType = "") {
-    double score = 0.0;
-    vector<string> configKeywords = cfg.soundCharacteristics.getEmotionalTags();
-    configKeywords.push_back(cfg.soundCharacteristics.timbral);
-    configKeywords.push_back(cfg.soundCharacteristics.material);
-    configKeywords.push_back(cfg.soundCharacteristics.dynamic);
-    configKeywords.push_back(cfg.topologicalMetadata.damping);
-    configKeywords.push_back(cfg.topologicalMetadata.spectralComplexity);
-    configKeywords.push_back(cfg.topologicalMetadata.manifoldPosition);
-    configKeywords.push_back(cfg.emotion);
-    configKeywords.push_back(cfg.topology);
-    configKeywords.push_back(cfg.instrumentType);
+// Split [0, count) into contiguous blocks, one per hardware thread, and run body(begin, end) on each
+template <typename Body>
+void parallelFor(size_t count, Body body) {
+    size_t threads = min<size_t>(max(1u, thread::hardware_concurrency()), count);
+    if (threads <= 1) {
+        if (count > 0) body(0, count);
+        return;
+    }
+    vector<thread> workers;
+    size_t chunk = (count + threads - 1) / threads;
+    for (size_t begin = 0; begin < count; begin += chunk) {
+        workers.emplace_back(body, begin, min(count, begin + chunk));
+    }
+    for (thread& t : workers) t.join();
+}
 
-    for (const string& tag : userTags) {
-        string ltag = lower(tag);
-        double maxMatch = 0.0;
-        for (const string& ckw : configKeywords) {
-            string lckw = lower(ckw);
-            if (skd.contains(lckw)) {
-                double tagScore = skd[lckw].value("score", 0.0);
-                if (ltag == lckw) {
-                    maxMatch = max(maxMatch, tagScore);
-                } else {
-                    vector<string> aliases = getStringVec(skd[lckw].value("aliases", json::array()));
-                    for (const string& alias : aliases) {
-                        if (lower(alias) == ltag) {
-                            maxMatch = max(maxMatch, tagScore * 0.8); // Reduced for alias
-                            break;
-                        }
-                    }
-                }
-                // Vectorization layer (incremental)
-                if (keywordVectors.find(ltag) != keywordVectors.end() && keywordVectors.find(lckw) != keywordVectors.end()) {
-    maxMatch *= cosineSimilarity(keywordVectors[ltag], keywordVectors[lckw]);
-               }
+// parallelFor with one task per index, each recording diagnostics on its own reserved sequence range,
+// so the merged diagnostics read as if the tasks had run in index order
+template <typename Body>
+void orderedParallelFor(size_t count, Body body) {
+    if (count == 0) return;
+    auto [first, size] = Diagnostics::instance().reserveSequence(count);
+    parallelFor(count, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            Diagnostics::SequenceScope scope(first + i * size, size);
+            body(i);
+        }
+    });
+}
+
+inline const vector<double>* keywordVector(const string& lowered) {
+    auto it = keywordVectors.find(lowered);
+    return it == keywordVectors.end() ? nullptr : &it->second;
+}
+
+// Sparse semantic profile of a SoundConfig: the SKD entries its descriptive fields resolve to, each
+// valued at entry score x keyword weight (emotional tags carry their own weight, other fields 1.0).
+struct SemanticProfile {
+    struct Term {
+        uint32_t canonical;
+        double value;
+        const vector<double>* vec;  // Keyword embedding, if any
+    };
+    vector<Term> terms;  // Sorted by canonical ID
+    string emotion, instrumentType;  // Lowercased for the exact-match bonuses
+};
+
+SemanticProfile buildSemanticProfile(const SoundConfig& cfg, const SkdIndex& index) {
+    vector<pair<string, float>> keywords = cfg.soundCharacteristics.emotional;
+    for (const string* field : {&cfg.soundCharacteristics.timbral, &cfg.soundCharacteristics.material,
+                                &cfg.soundCharacteristics.dynamic, &cfg.topologicalMetadata.damping,
+                                &cfg.topologicalMetadata.spectralComplexity, &cfg.topologicalMetadata.manifoldPosition,
+                                &cfg.emotion, &cfg.topology, &cfg.instrumentType}) {
+        keywords.emplace_back(*field, 1.0f);
+    }
+
+    SemanticProfile profile;
+    for (const auto& [keyword, weight] : keywords) {
+        string lkw = lower(keyword);
+        const SkdIndex::Posting* entry = index.entry(lkw);
+        if (!entry) continue;
+        double value = entry->score * weight;
+        auto it = find_if(profile.terms.begin(), profile.terms.end(),
+                          [&](const SemanticProfile::Term& t) { return t.canonical == entry->canonical; });
+        if (it != profile.terms.end()) it->value = max(it->value, value); // Repeated keyword keeps its strongest weight
+        else profile.terms.push_back({entry->canonical, value, keywordVector(lkw)});
+    }
+    sort(profile.terms.begin(), profile.terms.end(),
+         [](const SemanticProfile::Term& a, const SemanticProfile::Term& b) { return a.canonical < b.canonical; });
+    profile.emotion = lower(cfg.emotion);
+    profile.instrumentType = lower(cfg.instrumentType);
+    return profile;
+}
+
+// User tags compiled against the SKD: per tag, the entries it hits (1.0 as the key itself, 0.8 as an alias)
+struct SemanticQuery {
+    struct Hit {
+        uint32_t canonical;
+        double factor;
+    };
+    struct Tag {
+        vector<Hit> hits;  // Sorted by canonical ID
+        const vector<double>* vec;
+    };
+    vector<Tag> tags;
+    string mood, synthType;
+
+    static SemanticQuery compile(const vector<string>& userTags, const string& mood, const string& synthType, const SkdIndex& index) {
+        SemanticQuery query;
+        for (const string& tag : userTags) {
+            string ltag = lower(tag);
+            Tag compiled{{}, keywordVector(ltag)};
+            auto [first, last] = index.lookup(ltag);
+            for (const SkdIndex::Posting* p = first; p != last; ++p) {
+                compiled.hits.push_back({p->canonical, p->isAlias ? 0.8 : 1.0});
             }
+            query.tags.push_back(move(compiled));
         }
-        score += maxMatch;
+        query.mood = lower(mood);
+        query.synthType = lower(synthType);
+        return query;
     }
+};
+
+struct SemanticScore {
+    double tagSum = 0.0, moodBonus = 0.0, synthBonus = 0.0;
+    size_t tagCount = 0;
 
+    double total() const { return (tagSum + moodBonus + synthBonus) / (tagCount + 1e-6); } // Normalize
+    double tagsOnly() const { return tagSum / (tagCount + 1e-6); }
+};
+
+/**
+ * Score a profile against a query: each tag contributes its best hit (sparse merge on canonical ID),
+ * scaled by keyword-embedding similarity where both sides have one; mood and synth type add exact bonuses.
+ */
+SemanticScore scoreProfile(const SemanticProfile& profile, const SemanticQuery& query) {
+    SemanticScore result;
+    result.tagCount = query.tags.size();
+    for (const SemanticQuery::Tag& tag : query.tags) {
+        double maxMatch = 0.0;
+        auto term = profile.terms.begin();
+        for (const SemanticQuery::Hit& hit : tag.hits) {
+            while (term != profile.terms.end() && term->canonical < hit.canonical) ++term;
+            if (term == profile.terms.end()) break;
+            if (term->canonical != hit.canonical) continue;
+            double match = hit.factor * term->value;
+            if (tag.vec && term->vec) match *= cosineSimilarity(*tag.vec, *term->vec);
+            maxMatch = max(maxMatch, match);
+        }
+        result.tagSum += maxMatch;
+    }
     // Mood matching (new)
-    if (!mood.empty() && !cfg.emotion.empty()) {
-        score += (lower(mood) == lower(cfg.emotion)) ? 1.0 : 0.0; // Exact bonus
+    if (!query.mood.empty() && !profile.emotion.empty()) {
+        result.moodBonus = (query.mood == profile.emotion) ? 1.0 : 0.0; // Exact bonus
     }
-
     // Synth-profile matching (new)
-    if (!synthType.empty() && !cfg.instrumentType.empty()) {
-        score += (lower(synthType) == lower(cfg.instrumentType)) ? 1.0 : 0.0; // Exact bonus
+    if (!query.synthType.empty() && !profile.instrumentType.empty()) {
+        result.synthBonus = (query.synthType == profile.instrumentType) ? 1.0 : 0.0; // Exact bonus
     }
+    return result;
+}
 
-    return score / (userTags.size() + 1e-6); // Normalize
+// Function to compute semantic score for a config based on user tags (one-off; batch callers use scoreConfigs)
+double computeSemanticScore(const SoundConfig& cfg, const vector<string>& userTags, const string& mood = "", const string& synthType = "") {
+    shared_ptr<const SkdIndex> index = currentSkdIndex();
+    return scoreProfile(buildSemanticProfile(cfg, *index), SemanticQuery::compile(userTags, mood, synthType, *index)).total();
 }
 
 // SoundEngineeringQueue (complete loaders with fixes)
+// Philox4x32-10 counter-based RNG: four random words are a pure function of (counter, key), so any
+// variation can be drawn independently of the others, in any order and on any thread.
+struct Philox4x32 {
+    using Counter = array<uint32_t, 4>;
+    using Key = array<uint32_t, 2>;
+
+    static Counter generate(Counter ctr, Key key) {
+        for (int round = 0; round < 10; ++round) {
+            if (round > 0) {
+                key[0] += 0x9E3779B9u;
+                key[1] += 0xBB67AE85u;
+            }
+            uint64_t p0 = uint64_t(0xD2511F53u) * ctr[0];
+            uint64_t p1 = uint64_t(0xCD9E8D57u) * ctr[2];
+            ctr = {static_cast<uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0], static_cast<uint32_t>(p1),
+                   static_cast<uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1], static_cast<uint32_t>(p0)};
+        }
+        return ctr;
+    }
+
+    // Top 24 bits as a float in [0, 1)
+    static float uniform(uint32_t word) { return static_cast<float>(word >> 8) * (1.0f / 16777216.0f); }
+};
+
+/**
+ * Sampling dimensions of one base config, stored column-wise: each draws uniformly from
+ * [lo, lo + span] and is then clamped to [clampLo, clampHi] (infinite where no ParamMeta applies).
+ */
+struct VariationPlan {
+    vector<string> names;
+    vector<float> lo, span, clampLo, clampHi;
+
+    size_t dims() const { return names.size(); }
+
+    void add(string name, float a, float b, optional<pair<float, float>> clamp = nullopt) {
+        names.push_back(move(name));
+        lo.push_back(a);
+        span.push_back(b - a);
+        clampLo.push_back(clamp ? clamp->first : -numeric_limits<float>::infinity());
+        clampHi.push_back(clamp ? clamp->second : numeric_limits<float>::infinity());
+    }
+
+    /**
+     * Fill `out` (count x dims, row-major) for variations first..first+count. Uniforms come from
+     * Philox with counter (variation, configId, block) and the seed as key, then one branch-free pass
+     * over the columns turns them into values.
+     */
+    void sample(uint64_t first, size_t count, uint32_t configId, uint64_t seed, float* out) const {
+        size_t n = dims();
+        Philox4x32::Key key = {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)};
+        for (size_t v = 0; v < count; ++v) {
+            uint64_t variation = first + v;
+            float* row = out + v * n;
+            for (size_t block = 0; block * 4 < n; ++block) {
+                Philox4x32::Counter words = Philox4x32::generate(
+                    {static_cast<uint32_t>(variation), static_cast<uint32_t>(variation >> 32), configId, static_cast<uint32_t>(block)}, key);
+                for (size_t w = 0; w < 4 && block * 4 + w < n; ++w) row[block * 4 + w] = Philox4x32::uniform(words[w]);
+            }
+            const float* l = lo.data();
+            const float* s = span.data();
+            const float* cl = clampLo.data();
+            const float* ch = clampHi.data();
+            for (size_t d = 0; d < n; ++d) row[d] = min(max(l[d] + row[d] * s[d], cl[d]), ch[d]);
+        }
+    }
+};
+
+enum class VariationFormat : uint8_t { Jsonl, Binary };
+
 class SoundEngineeringQueue {
 public:
-    void loadAndMerge() {
+    void loadAndMerge(bool verbose = true) {
         // Example registrations (C. Dynamic Registration)
         map<string, ParamMeta> reverbSchema;
         reverbSchema["decay"] = {"Decay Time", 0.0f, 10.0f, "s", "Reverb decay time", true, "float"};
@@ -902,226 +2883,551 @@ public:
         distortionSchema["ai_control"] = {"AI Control", 0.0f, 0.0f, "", "Enable AI modulation", false, "bool"};
         BaseParamStruct::registerSchema("distortion", distortionSchema);
 
-        // Load files
-        load_guitar("guitar.json");
-        load_group("group.json");
-        load_moods("moods.json");
-        load_synth("Synthesizer.json");
-        load_structure("structure.json");
+        // Parse all five files concurrently, then merge them in order: each merge sees the configs the
+        // earlier files produced. Diagnostics get one sequence range per file (parse half, then merge
+        // half) so they come out in the same order as a serial load.
+        // Each file with its loader and where its parameter sections sit (alias keys are canonicalized there)
+        using Loader = void (SoundEngineeringQueue::*)(const json&);
+        struct InputFile {
+            const char* name;
+            Loader load;
+            vector<string> sections;
+        };
+        static const array<InputFile, 5> FILES = {{
+            {"guitar.json", &SoundEngineeringQueue::load_guitar, {"guitar_types", "*", "groups", "*"}},
+            {"group.json", &SoundEngineeringQueue::load_group, {"groups", "*"}},
+            {"moods.json", &SoundEngineeringQueue::load_moods, {"moods", "[]"}},
+            {"Synthesizer.json", &SoundEngineeringQueue::load_synth, {"sections", "*"}},
+            {"structure.json", &SoundEngineeringQueue::load_structure, {"sections", "[]"}},
+        }};
+        array<optional<json>, FILES.size()> parsed;
+        optional<SchemaRegistry::Batch> schemaBatch(in_place); // Keys discovered by the loaders publish once
+        size_t heapAllocsBefore = HeapStats::allocations.load(), heapBytesBefore = HeapStats::bytes.load();
+        auto [seqFirst, seqSize] = Diagnostics::instance().reserveSequence(FILES.size());
+        parallelFor(FILES.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                Diagnostics::SequenceScope scope(seqFirst + i * seqSize, seqSize / 2);
+                parsed[i] = parseFile(FILES[i].name, FILES[i].sections);
+            }
+        });
+        for (size_t i = 0; i < FILES.size(); ++i) {
+            Diagnostics::SequenceScope scope(seqFirst + i * seqSize + seqSize / 2, seqSize / 2);
+            if (parsed[i]) (this->*FILES[i].load)(*parsed[i]);
+            parsed[i].reset(); // Done with this tree
+        }
+        schemaBatch.reset();
+        loadHeapAllocations = HeapStats::allocations.load() - heapAllocsBefore;
+        loadHeapBytes = HeapStats::bytes.load() - heapBytesBefore;
+        Diagnostics::instance().flush(); // Emit everything the loaders recorded in one batch
+        reportRegisteredEffects();
+        reportAllocations();
+        reportEffectiveParams();
+        buildProfiles(currentSkdIndex());
+        if (verbose) {
+            for (const auto& [key, cfg] : configs) {
+                reportLoaded(key); // Print loaded/missing report
+            }
+        }
+        saveConfig(saveFormat == SaveFormat::Cbor ? "config.cbor" : "config.json");
+    }
+
+    void setSaveFormat(SaveFormat format) { saveFormat = format; }
+
+    // Resolved ADSR/gate/gain per (config, section) for the renderer; valid after loadAndMerge
+    const EffectiveParamTable& effectiveParamTable() const { return effectiveParams; }
+
+    /**
+     * Monte Carlo preset variations: `perConfig` concrete parameter sets for every config (or only
+     * `onlyConfig`) with at least one ranged parameter, streamed to `output`. The same seed always
+     * gives the same file. JSONL is one {"config", "variation", "params"} object per line. Binary is
+     * the magic "SEVARS01" and the uint64 seed, then per config: uint32 key length + key, uint32
+     * dims, per dim uint32 name length + name, uint64 count, and count x dims float32 values, all
+     * in host byte order.
+     */
+    void generateVariations(size_t perConfig, const string& output, VariationFormat format, uint64_t seed,
+                            const string& onlyConfig = "") const {
+        ofstream out(output, ios::binary);
+        if (!out) {
+            cerr << "[Warn] Couldn't open " << output << " for writing" << endl;
+            return;
+        }
+        auto writeU32 = [&](uint32_t v) { out.write(reinterpret_cast<const char*>(&v), sizeof v); };
+        auto writeU64 = [&](uint64_t v) { out.write(reinterpret_cast<const char*>(&v), sizeof v); };
+        auto writeString = [&](const string& str) {
+            writeU32(static_cast<uint32_t>(str.size()));
+            out.write(str.data(), static_cast<streamsize>(str.size()));
+        };
+        if (format == VariationFormat::Binary) {
+            out.write("SEVARS01", 8);
+            writeU64(seed);
+        }
+
+        constexpr size_t CHUNK = 4096, BLOCK = 256; // Variations per write, and per parallel task
+        auto start = chrono::steady_clock::now();
+        size_t configsUsed = 0, totalDims = 0, total = 0;
+        vector<float> values;
+        vector<string> pieces;
+        uint32_t configId = 0;
         for (const auto& [key, cfg] : configs) {
-            reportLoaded(key); // Print loaded/missing report
+            uint32_t id = configId++; // Position in the config map, so a config's stream doesn't depend on the filter
+            if (!onlyConfig.empty() && key != onlyConfig) continue;
+            VariationPlan plan = variationPlan(cfg);
+            size_t dims = plan.dims();
+            if (dims == 0) continue;
+            ++configsUsed;
+            totalDims += dims;
+
+            string prefix = "{\"config\":" + json(key).dump() + ",\"variation\":";
+            vector<string> fieldNames; // Quoted and escaped once, with the colon
+            for (const string& name : plan.names) fieldNames.push_back(json(name).dump() + ":");
+            if (format == VariationFormat::Binary) {
+                writeString(key);
+                writeU32(static_cast<uint32_t>(dims));
+                for (const string& name : plan.names) writeString(name);
+                writeU64(perConfig);
+            }
+
+            for (size_t first = 0; first < perConfig; first += CHUNK) {
+                size_t count = min(CHUNK, perConfig - first);
+                values.resize(count * dims);
+                pieces.assign((count + BLOCK - 1) / BLOCK, string());
+                parallelFor(pieces.size(), [&](size_t begin, size_t end) {
+                    char number[32];
+                    for (size_t b = begin; b < end; ++b) {
+                        size_t v0 = b * BLOCK, n = min(BLOCK, count - v0);
+                        float* rows = values.data() + v0 * dims;
+                        plan.sample(first + v0, n, id, seed, rows);
+                        if (format != VariationFormat::Jsonl) continue;
+                        string& text = pieces[b];
+                        for (size_t v = 0; v < n; ++v) {
+                            text += prefix;
+                            text.append(number, to_chars(number, number + sizeof number, first + v0 + v).ptr);
+                            text += ",\"params\":{";
+                            for (size_t d = 0; d < dims; ++d) {
+                                if (d) text += ',';
+                                text += fieldNames[d];
+                                text.append(number, to_chars(number, number + sizeof number, rows[v * dims + d]).ptr);
+                            }
+                            text += "}}\n";
+                        }
+                    }
+                });
+                if (format == VariationFormat::Binary) {
+                    out.write(reinterpret_cast<const char*>(values.data()), static_cast<streamsize>(values.size() * sizeof(float)));
+                } else {
+                    for (const string& piece : pieces) out.write(piece.data(), static_cast<streamsize>(piece.size()));
+                }
+                total += count;
+            }
+        }
+        double bytes = static_cast<double>(out.tellp());
+        out.close();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "Variations: " << total << " from " << configsUsed << " config(s), " << totalDims << " ranged param(s) -> "
+             << output << " (" << seconds << " s, " << total / seconds << " variations/s, " << bytes / seconds / 1e6 << " MB/s)" << endl;
+    }
+
+    /**
+     * --bench-save: throughput of the tree-then-dump path against the streaming writer in each
+     * encoding, written to memory so the disk is out of the picture; also checks the outputs agree.
+     */
+    void benchmarkSave(size_t iterations) const {
+        using clock = chrono::steady_clock;
+        auto streamed = [&](SaveFormat format) {
+            ostringstream out;
+            ConfigWriter writer(out, format);
+            writeConfig(writer);
+            writer.flush();
+            return out.str();
+        };
+
+        json reference = buildConfigJson();
+        bool prettyMatches = streamed(SaveFormat::Pretty) == reference.dump(4);
+        bool compactMatches = streamed(SaveFormat::Compact) == reference.dump();
+        string cbor = streamed(SaveFormat::Cbor);
+        bool cborMatches = json::from_cbor(cbor) == reference;
+
+        size_t bytes = 0;
+        auto start = clock::now();
+        for (size_t it = 0; it < iterations; ++it) bytes += buildConfigJson().dump(4).size();
+        double treeSec = chrono::duration<double>(clock::now() - start).count();
+
+        cout << "Save benchmark (" << iterations << " iteration(s), " << configs.size() << " configs)" << endl;
+        cout << "  tree + dump(4)   : " << bytes / treeSec / 1e6 << " MB/s, " << treeSec * 1e3 / iterations << " ms/save" << endl;
+        const pair<const char*, SaveFormat> formats[] = {
+            {"stream pretty    ", SaveFormat::Pretty}, {"stream compact   ", SaveFormat::Compact}, {"stream cbor      ", SaveFormat::Cbor}};
+        for (const auto& [label, format] : formats) {
+            bytes = 0;
+            start = clock::now();
+            for (size_t it = 0; it < iterations; ++it) {
+                ostringstream out;
+                ConfigWriter writer(out, format);
+                writeConfig(writer);
+                bytes += writer.bytesWritten();
+            }
+            double sec = chrono::duration<double>(clock::now() - start).count();
+            cout << "  " << label << ": " << bytes / sec / 1e6 << " MB/s, " << sec * 1e3 / iterations << " ms/save ("
+                 << treeSec / sec << "x), " << bytes / iterations << " bytes" << endl;
         }
-        saveConfig("config.json");
+        cout << "  output matches tree: pretty " << (prettyMatches ? "yes" : "NO") << ", compact "
+             << (compactMatches ? "yes" : "NO") << ", cbor " << (cborMatches ? "yes" : "NO") << endl;
     }
     
 
+    struct ScoredConfig {
+        const string* key;
+        const SoundConfig* cfg;
+        SemanticScore score;
+    };
+
+    /**
+     * Scored candidates for one menu flow. Configs are scored once for a (tags, mood, synth type) query and
+     * ranked once; suggestions, base-instrument choice and layer picks then read filtered views of it.
+     */
+    class CandidateCache {
+    public:
+        bool matches(const vector<string>& t, const string& m, const string& s, uint64_t generation) const {
+            return valid && profileGeneration == generation && tags == t && mood == m && synthType == s;
+        }
+
+        bool matchesTags(const vector<string>& t, uint64_t generation) const {
+            return valid && profileGeneration == generation && tags == t;
+        }
+
+        void assign(const vector<string>& t, const string& m, const string& s, uint64_t generation, vector<ScoredConfig> scoredConfigs) {
+            tags = t;
+            mood = m;
+            synthType = s;
+            profileGeneration = generation;
+            scored = move(scoredConfigs);
+            ranked.clear();
+            ranked.reserve(scored.size());
+            for (const ScoredConfig& entry : scored) ranked.push_back(&entry);
+            // Highest score first; ties keep config key order
+            stable_sort(ranked.begin(), ranked.end(), [](const ScoredConfig* a, const ScoredConfig* b) {
+                return a->score.total() > b->score.total();
+            });
+            valid = true;
+        }
+
+        const vector<ScoredConfig>& all() const { return scored; } // Config key order
+        size_t size() const { return scored.size(); }
+
+        // Best k by total score, optionally restricted by a predicate on the config
+        template <typename Pred>
+        vector<const ScoredConfig*> top(size_t k, Pred pred) const {
+            vector<const ScoredConfig*> out;
+            for (const ScoredConfig* entry : ranked) {
+                if (out.size() >= k) break;
+                if (pred(*entry->cfg)) out.push_back(entry);
+            }
+            return out;
+        }
+
+        vector<const ScoredConfig*> top(size_t k) const {
+            return top(k, [](const SoundConfig&) { return true; });
+        }
+
+        // Ranked prefix scoring at least `threshold`
+        vector<const ScoredConfig*> aboveThreshold(double threshold) const {
+            auto end = partition_point(ranked.begin(), ranked.end(),
+                                       [&](const ScoredConfig* entry) { return entry->score.total() >= threshold; });
+            return vector<const ScoredConfig*>(ranked.begin(), end);
+        }
+
+    private:
+        bool valid = false;
+        vector<string> tags;
+        string mood, synthType;
+        uint64_t profileGeneration = 0;
+        vector<ScoredConfig> scored;
+        vector<const ScoredConfig*> ranked;
+    };
+
 private:
-    map<string, SoundConfig> configs;
-    map<string, GroupConfig> groupConfigs;
+    // Config storage lives in a pool owned by the queue: the containers' node and buffer requests
+    // are counted on the way in (poolCounter) and the pool's own heap requests on the way out
+    // (heapCounter). Declared before the containers so the pool outlives them. Synchronized because
+    // the loaders fill configs from parallel tasks.
+    CountingResource heapCounter{pmr::new_delete_resource()};
+    pmr::synchronized_pool_resource configPool{&heapCounter};
+    CountingResource poolCounter{&configPool};
+    pmr::map<string, SoundConfig> configs{&poolCounter};
+    pmr::map<string, GroupConfig> groupConfigs{&poolCounter};
+    size_t loadHeapAllocations = 0, loadHeapBytes = 0; // Every operator new made while parsing and merging the last load
+    vector<tuple<const string*, const SoundConfig*, SemanticProfile>> profiles; // Config key order
+    shared_ptr<const SkdIndex> profileIndex; // SKD table the profiles were built against
+    uint64_t profileGeneration = 0; // Bumped on every rebuild so cached scores go stale with the profiles
+    CandidateCache session;
+    SaveFormat saveFormat = SaveFormat::Pretty;
+    EffectiveParamTable effectiveParams; // Rebuilt by load_structure
+    GainTables gainTables; // Mood offsets filled by load_moods, section factors by load_synth
+    map<string, vector<pair<string, Range>>> moodRanges; // Per mood, the numeric fields of moods.json in file order
+
+    // Top-level section a config is saved under in config.json
+    enum class SaveSection : uint8_t { Guitar, Group, Synth, Other };
+
+    static SaveSection sectionOf(const string& key, const SoundConfig& cfg) {
+        if (cfg.instrumentType.find("guitar") != string::npos) return SaveSection::Guitar;
+        if (cfg.instrumentType != "synth") return SaveSection::Other;
+        bool grouped = key.find("pad_") != string::npos || key.find("bass_") != string::npos;
+        return grouped ? SaveSection::Group : SaveSection::Synth;
+    }
 
-    void load_guitar(const string& file) {
+    // Registered schemas plus the version field, keys in sorted order
+    static void writeSchema(ConfigWriter& w) {
+        static const string VERSION = "version";
+        shared_ptr<const SchemaSnapshot> snapshot = SchemaRegistry::current();
+        bool versionWritten = false;
+        w.beginObject();
+        for (const auto& [type, schema] : snapshot->registered) {
+            if (type == VERSION) continue; // The version field wins, as in the tree form
+            if (!versionWritten && VERSION < type) {
+                w.field(VERSION, snapshot->version);
+                versionWritten = true;
+            }
+            w.key(type);
+            w.beginObject();
+            for (const auto& [param, meta] : schema) w.field(param, meta.to_json());
+            w.endObject();
+        }
+        if (!versionWritten) w.field(VERSION, snapshot->version);
+        w.endObject();
+    }
+
+    void buildProfiles(const shared_ptr<const SkdIndex>& index) {
+        profiles.clear();
+        profiles.reserve(configs.size());
+        for (const auto& [key, cfg] : configs) profiles.emplace_back(&key, &cfg, SemanticProfile{});
+        parallelFor(profiles.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) get<2>(profiles[i]) = buildSemanticProfile(*get<1>(profiles[i]), *index);
+        });
+        profileIndex = index;
+        ++profileGeneration;
+    }
+
+    // Parse one input file, canonicalizing alias keys inside the loader's sections (see AliasingSaxBuilder)
+    static optional<json> parseFile(const string& file, const vector<string>& sections) {
         ifstream inFile(file);
-        if (!inFile) { cerr << "[Warn] Couldn't open " << file << endl; return; }
-        json j; inFile >> j;
+        if (!inFile) {
+            diag(DiagCode::FileNotOpened, file);
+            return nullopt;
+        }
+        json doc;
+        AliasingSaxBuilder builder(doc, file, sections);
+        json::sax_parse(inFile, &builder);
+        return doc;
+    }
+
+    void load_guitar(const json& j) {
         if (!j.is_object()) {
-            cerr << "[TypeError] Expected object for guitar.json root, got " << j.type_name() << endl;
+            diag(DiagCode::ExpectedObject, "guitar.json root", "object", j.type_name());
             return;
         }
         if (j.contains("guitar_types") && j["guitar_types"].is_object()) {
+            ConfigTasks tasks;
             for (auto& [gtype, gval] : j["guitar_types"].items()) {
                 if (gval.is_object() && gval.contains("groups") && gval["groups"].is_object()) {
-                    for (auto& [gname, params] : gval["groups"].items()) {
-                        string configKey = lower(gname);
-                        resolveAliases(params, configKey);
-                        SoundConfig cfg;
-                        cfg.instrumentType = gtype;
-
-                        // Oscillator types
-                        if (params.contains("oscillator") && params["oscillator"].is_object() && params["oscillator"].contains("types") && params["oscillator"]["types"].is_array()) {
-                            cfg.oscTypes["osc1"] = getStringVec(params["oscillator"]["types"], configKey + ".oscillator.types");
-                        }
-
-                        // Envelope
-                        if (params.contains("envelope") && params["envelope"].is_object()) {
-                            auto& e = params["envelope"];
-                            if (e.contains("type") && e["type"].is_string()) {
-                                cfg.guitarParams.stringParams["type"] = e["type"].get<string>();
-                            }
-                            if (e.contains("curve") && e["curve"].is_string()) {
-                                cfg.guitarParams.stringParams["curve"] = e["curve"].get<string>();
-                            }
-                            for (string param : {"attack", "decay", "sustain", "release", "delay", "hold"}) {
-                                if (e.contains(param)) {
-                                    cfg.adsr["osc"][param].from_json(e[param]);
-                                }
-                            }
-                        }
-
-                        // Filter
-                        if (params.contains("filter") && params["filter"].is_object()) {
-                            auto& f = params["filter"];
-                            if (f.contains("cutoff")) {
-                                cfg.guitarParams.storeParam("cutoff", f["cutoff"], configKey + ".filter.cutoff");
-                            }
-                            if (f.contains("resonance")) {
-                                cfg.guitarParams.storeParam("resonance", f["resonance"], configKey + ".filter.resonance");
-                            }
-                            if (f.contains("envelope_amount")) {
-                                cfg.guitarParams.storeParam("envelope_amount", f["envelope_amount"], configKey + ".filter.envelope_amount");
-                            }
-                            if (f.contains("slope") && f["slope"].is_string()) {
-                                cfg.guitarParams.stringParams["slope"] = f["slope"].get<string>();
-                            }
-                            if (f.contains("type") && f["type"].is_string()) {
-                                cfg.guitarParams.stringParams["filter_type"] = f["type"].get<string>();
-                            }
-                        }
+                    for (auto& [gname, params] : gval["groups"].items()) tasks.add(lower(gname), gtype, params);
+                } else {
+                    diag(DiagCode::MissingSection, "guitar_types." + gtype, "groups", "object");
+                }
+            }
+            vector<SoundConfig*> targets;
+            for (const auto& task : tasks.tasks) targets.push_back(&configs.try_emplace(task.configKey).first->second);
+
+            // Each config is built by its own task, in place in the (synchronized) config pool
+            orderedParallelFor(tasks.tasks.size(), [&](size_t t) {
+                const string& configKey = tasks.tasks[t].configKey;
+                SoundConfig& cfg = *targets[t];
+                for (const auto& [gtype, entry] : tasks.tasks[t].entries) {
+                    const json& params = *entry;
+                    // A later group with the same key replaces the earlier one
+                    cfg = SoundConfig(configs.get_allocator());
+                    cfg.instrumentType = gtype;
+
+                    // Oscillator types
+                    if (params.contains("oscillator") && params["oscillator"].is_object() && params["oscillator"].contains("types") && params["oscillator"]["types"].is_array()) {
+                        assignOscTypes(cfg.oscTypes["osc1"], getStringVec(params["oscillator"]["types"], configKey + ".oscillator.types"));
+                    }
 
-                        // Strings
-                        if (params.contains("strings") && params["strings"].is_object()) {
-                            auto& s = params["strings"];
-                            if (s.contains("material") && s["material"].is_string()) {
-                                cfg.guitarParams.stringParams["material"] = s["material"].get<string>();
-                            }
-                            if (s.contains("gauge") && s["gauge"].is_string()) {
-                                cfg.guitarParams.stringParams["gauge"] = s["gauge"].get<string>();
-                            }
-                            if (s.contains("tension") && s["tension"].is_string()) {
-                                cfg.guitarParams.stringParams["tension"] = s["tension"].get<string>();
-                            }
-                            if (s.contains("num_strings") && s["num_strings"].is_number()) {
-                                cfg.guitarParams.stringParams["num_strings"] = to_string(s["num_strings"].get<int>());
-                            }
-                            if (s.contains("ai_control") && s["ai_control"].is_boolean()) {
-                                cfg.guitarParams.boolParams["ai_control"] = s["ai_control"].get<bool>();
-                            }
-                            if (s.contains("tuning") && s["tuning"].is_array()) {
-                                cfg.guitarParams.stringParams["tuning"] = join(getStringVec(s["tuning"], configKey + ".strings.tuning"), ",");
-                            }
-                            if (s.contains("detune_range")) {
-                                vector<float> detune = getFloatVec(s["detune_range"], configKey + ".strings.detune_range");
-                                if (!detune.empty()) {
-                                    cfg.guitarParams.vectorParams["detune_range"] = detune;
-                                }
+                    // Envelope
+                    if (params.contains("envelope") && params["envelope"].is_object()) {
+                        auto& e = params["envelope"];
+                        if (e.contains("type") && e["type"].is_string()) {
+                            cfg.guitarParams.setString("type", e["type"].get<string>());
+                        }
+                        if (e.contains("curve") && e["curve"].is_string()) {
+                            cfg.guitarParams.setString("curve", e["curve"].get<string>());
+                        }
+                        for (size_t stage = 0; stage < AdsrTable::STAGE_COUNT; ++stage) {
+                            const char* param = AdsrTable::STAGE_NAMES[stage];
+                            if (e.contains(param)) {
+                                cfg.adsr.set(AdsrTable::Osc, AdsrTable::Stage(stage), e[param]);
                             }
                         }
+                    }
 
-                        // Harmonics
-                        if (params.contains("harmonics") && params["harmonics"].is_object()) {
-                            auto& h = params["harmonics"];
-                            if (h.contains("vibe_set") && h["vibe_set"].is_array()) {
-                                cfg.guitarParams.vectorParams["vibe_set"] = getFloatVec(h["vibe_set"], configKey + ".harmonics.vibe_set");
-                            }
-                            if (h.contains("decay_rate") && h["decay_rate"].is_array()) {
-                                cfg.guitarParams.vectorParams["decay_rate"] = getFloatVec(h["decay_rate"], configKey + ".harmonics.decay_rate");
-                            }
-                            if (h.contains("sympathetic_resonance") && h["sympathetic_resonance"].is_object()) {
-                                auto& sr = h["sympathetic_resonance"];
-                                if (sr.contains("harmonics") && sr["harmonics"].is_array()) {
-                                    cfg.guitarParams.vectorParams["sympathetic_harmonics"] = getFloatVec(sr["harmonics"], configKey + ".sympathetic_resonance.harmonics");
-                                }
-                                if (sr.contains("volume") && sr["volume"].is_array()) {
-                                    cfg.guitarParams.vectorParams["sympathetic_volume"] = getFloatVec(sr["volume"], configKey + ".sympathetic_resonance.volume");
-                                }
-                                if (sr.contains("num_layers") && sr["num_layers"].is_number()) {
-                                    cfg.guitarParams.vectorParams["sympathetic_num_layers"] = {static_cast<float>(sr["num_layers"].get<int>())};
-                                }
-                                if (sr.contains("randomize_range") && sr["randomize_range"].is_array()) {
-                                    cfg.guitarParams.vectorParams["sympathetic_randomize_range"] = getFloatVec(sr["randomize_range"], configKey + ".sympathetic_resonance.randomize_range");
-                                }
-                            }
+                    // Filter
+                    if (params.contains("filter") && params["filter"].is_object()) {
+                        auto& f = params["filter"];
+                        if (f.contains("cutoff")) {
+                            cfg.guitarParams.storeParam("cutoff", f["cutoff"], configKey + ".filter.cutoff");
+                        }
+                        if (f.contains("resonance")) {
+                            cfg.guitarParams.storeParam("resonance", f["resonance"], configKey + ".filter.resonance");
+                        }
+                        if (f.contains("envelope_amount")) {
+                            cfg.guitarParams.storeParam("envelope_amount", f["envelope_amount"], configKey + ".filter.envelope_amount");
                         }
+                        if (f.contains("slope") && f["slope"].is_string()) {
+                            cfg.guitarParams.setString("slope", f["slope"].get<string>());
+                        }
+                        if (f.contains("type") && f["type"].is_string()) {
+                            cfg.guitarParams.setString("filter_type", f["type"].get<string>());
+                        }
+                    }
 
-                        // Body resonance
-                        if (params.contains("body_resonance") && params["body_resonance"].is_object()) {
-                            auto& br = params["body_resonance"];
-                            if (br.contains("mix")) {
-                                cfg.guitarParams.storeParam("mix", br["mix"], configKey + ".body_resonance.mix");
-                            }
-                            if (br.contains("ir_file") && br["ir_file"].is_string()) {
-                                cfg.guitarParams.stringParams["ir_file"] = br["ir_file"].get<string>();
+                    // Strings
+                    if (params.contains("strings") && params["strings"].is_object()) {
+                        auto& s = params["strings"];
+                        if (s.contains("material") && s["material"].is_string()) {
+                            cfg.guitarParams.setString("material", s["material"].get<string>());
+                        }
+                        if (s.contains("gauge") && s["gauge"].is_string()) {
+                            cfg.guitarParams.setString("gauge", s["gauge"].get<string>());
+                        }
+                        if (s.contains("tension") && s["tension"].is_string()) {
+                            cfg.guitarParams.setString("tension", s["tension"].get<string>());
+                        }
+                        if (s.contains("num_strings") && s["num_strings"].is_number()) {
+                            cfg.guitarParams.setString("num_strings", to_string(s["num_strings"].get<int>()));
+                        }
+                        if (s.contains("ai_control") && s["ai_control"].is_boolean()) {
+                            cfg.guitarParams.setBool("ai_control", s["ai_control"].get<bool>());
+                        }
+                        if (s.contains("tuning") && s["tuning"].is_array()) {
+                            cfg.guitarParams.setString("tuning", join(getStringVec(s["tuning"], configKey + ".strings.tuning"), ","));
+                        }
+                        if (s.contains("detune_range")) {
+                            vector<float> detune = getFloatVec(s["detune_range"], configKey + ".strings.detune_range");
+                            if (!detune.empty()) {
+                                cfg.guitarParams.setVector("detune_range", detune);
                             }
                         }
+                    }
 
-                        // Attack noise
-                        if (params.contains("attack_noise") && params["attack_noise"].is_object()) {
-                            auto& a = params["attack_noise"];
-                            if (a.contains("intensity")) {
-                                cfg.guitarParams.storeParam("intensity", a["intensity"], configKey + ".attack_noise.intensity");
+                    // Harmonics
+                    if (params.contains("harmonics") && params["harmonics"].is_object()) {
+                        auto& h = params["harmonics"];
+                        if (h.contains("vibe_set") && h["vibe_set"].is_array()) {
+                            cfg.guitarParams.setVector("vibe_set", getFloatVec(h["vibe_set"], configKey + ".harmonics.vibe_set"));
+                        }
+                        if (h.contains("decay_rate") && h["decay_rate"].is_array()) {
+                            cfg.guitarParams.setVector("decay_rate", getFloatVec(h["decay_rate"], configKey + ".harmonics.decay_rate"));
+                        }
+                        if (h.contains("sympathetic_resonance") && h["sympathetic_resonance"].is_object()) {
+                            auto& sr = h["sympathetic_resonance"];
+                            if (sr.contains("harmonics") && sr["harmonics"].is_array()) {
+                                cfg.guitarParams.setVector("sympathetic_harmonics", getFloatVec(sr["harmonics"], configKey + ".sympathetic_resonance.harmonics"));
                             }
-                            if (a.contains("probability")) {
-                                cfg.guitarParams.storeParam("probability", a["probability"], configKey + ".attack_noise.probability");
+                            if (sr.contains("volume") && sr["volume"].is_array()) {
+                                cfg.guitarParams.setVector("sympathetic_volume", getFloatVec(sr["volume"], configKey + ".sympathetic_resonance.volume"));
                             }
-                            if (a.contains("burst_length")) {
-                                cfg.guitarParams.storeParam("burst_length", a["burst_length"], configKey + ".attack_noise.burst_length");
+                            if (sr.contains("num_layers") && sr["num_layers"].is_number()) {
+                                cfg.guitarParams.setVector("sympathetic_num_layers", {static_cast<float>(sr["num_layers"].get<int>())});
                             }
-                            if (a.contains("noise_type") && a["noise_type"].is_string()) {
-                                cfg.guitarParams.stringParams["noise_type"] = a["noise_type"].get<string>();
+                            if (sr.contains("randomize_range") && sr["randomize_range"].is_array()) {
+                                cfg.guitarParams.setVector("sympathetic_randomize_range", getFloatVec(sr["randomize_range"], configKey + ".sympathetic_resonance.randomize_range"));
                             }
                         }
+                    }
 
-                        // Pick
-                        if (params.contains("pick") && params["pick"].is_object()) {
-                            auto& p = params["pick"];
-                            if (p.contains("position")) {
-                                cfg.guitarParams.storeParam("position", p["position"], configKey + ".pick.position");
-                            }
-                            if (p.contains("noiseProbability")) {
-                                cfg.guitarParams.storeParam("noiseProbability", p["noiseProbability"], configKey + ".pick.noiseProbability");
-                            }
-                            if (p.contains("noiseIntensity")) {
-                                cfg.guitarParams.storeParam("noiseIntensity", p["noiseIntensity"], configKey + ".pick.noiseIntensity");
-                            }
-                            if (p.contains("stiffness") && p["stiffness"].is_string()) {
-                                cfg.guitarParams.stringParams["stiffness"] = p["stiffness"].get<string>();
-                            }
+                    // Body resonance
+                    if (params.contains("body_resonance") && params["body_resonance"].is_object()) {
+                        auto& br = params["body_resonance"];
+                        if (br.contains("mix")) {
+                            cfg.guitarParams.storeParam("mix", br["mix"], configKey + ".body_resonance.mix");
                         }
+                        if (br.contains("ir_file") && br["ir_file"].is_string()) {
+                            cfg.guitarParams.setString("ir_file", br["ir_file"].get<string>());
+                        }
+                    }
 
-                        // Vibrato
-                        if (params.contains("vibrato") && params["vibrato"].is_object()) {
-                            auto& v = params["vibrato"];
-                            if (v.contains("vibrato_hz")) {
-                                cfg.guitarParams.storeParam("vibratoHz", v["vibrato_hz"], configKey + ".vibrato.vibrato_hz");
-                            }
-                            if (v.contains("depth_cents")) {
-                                cfg.guitarParams.storeParam("depth", v["depth_cents"], configKey + ".vibrato.depth_cents");
-                            }
-                            if (v.contains("freq_range")) {
-                                cfg.guitarParams.storeParam("freq_range", v["freq_range"], configKey + ".vibrato.freq_range");
-                            }
+                    // Attack noise
+                    if (params.contains("attack_noise") && params["attack_noise"].is_object()) {
+                        auto& a = params["attack_noise"];
+                        if (a.contains("intensity")) {
+                            cfg.guitarParams.storeParam("intensity", a["intensity"], configKey + ".attack_noise.intensity");
+                        }
+                        if (a.contains("probability")) {
+                            cfg.guitarParams.storeParam("probability", a["probability"], configKey + ".attack_noise.probability");
                         }
+                        if (a.contains("burst_length")) {
+                            cfg.guitarParams.storeParam("burst_length", a["burst_length"], configKey + ".attack_noise.burst_length");
+                        }
+                        if (a.contains("noise_type") && a["noise_type"].is_string()) {
+                            cfg.guitarParams.setString("noise_type", a["noise_type"].get<string>());
+                        }
+                    }
 
-                        // Effects
-                        if (params.contains("fx") && params["fx"].is_array()) {
-                            for (const auto& fx : params["fx"]) {
-                                if (fx.is_object()) {
-                                    Fx fxStruct;
-                                    fxStruct.from_json(fx);
-                                    cfg.effects.push_back(fxStruct);
-                                } else {
-                                    cerr << "[TypeError] Fx item is not an object in " << configKey << ": " << fx << endl;
-                                }
-                            }
+                    // Pick
+                    if (params.contains("pick") && params["pick"].is_object()) {
+                        auto& p = params["pick"];
+                        if (p.contains("position")) {
+                            cfg.guitarParams.storeParam("position", p["position"], configKey + ".pick.position");
                         }
+                        if (p.contains("noiseProbability")) {
+                            cfg.guitarParams.storeParam("noiseProbability", p["noiseProbability"], configKey + ".pick.noiseProbability");
+                        }
+                        if (p.contains("noiseIntensity")) {
+                            cfg.guitarParams.storeParam("noiseIntensity", p["noiseIntensity"], configKey + ".pick.noiseIntensity");
+                        }
+                        if (p.contains("stiffness") && p["stiffness"].is_string()) {
+                            cfg.guitarParams.setString("stiffness", p["stiffness"].get<string>());
+                        }
+                    }
 
-                        // Metadata
-                        if (params.contains("sound_characteristics") && params["sound_characteristics"].is_object()) {
-                            cfg.guitarParams.soundCharacteristics.from_json(params["sound_characteristics"]);
-                            cfg.soundCharacteristics = cfg.guitarParams.soundCharacteristics;
+                    // Vibrato
+                    if (params.contains("vibrato") && params["vibrato"].is_object()) {
+                        auto& v = params["vibrato"];
+                        if (v.contains("vibrato_hz")) {
+                            cfg.guitarParams.storeParam("vibratoHz", v["vibrato_hz"], configKey + ".vibrato.vibrato_hz");
                         }
-                        if (params.contains("topological_metadata") && params["topological_metadata"].is_object()) {
-                            cfg.guitarParams.topologicalMetadata.from_json(params["topological_metadata"]);
-                            cfg.topologicalMetadata = cfg.guitarParams.topologicalMetadata;
+                        if (v.contains("depth_cents")) {
+                            cfg.guitarParams.storeParam("depth", v["depth_cents"], configKey + ".vibrato.depth_cents");
                         }
+                        if (v.contains("freq_range")) {
+                            cfg.guitarParams.storeParam("freq_range", v["freq_range"], configKey + ".vibrato.freq_range");
+                        }
+                    }
+
+                    // Effects
+                    if (params.contains("fx") && params["fx"].is_array()) {
+                        for (const auto& fx : params["fx"]) {
+                            if (fx.is_object()) {
+                                Fx fxStruct;
+                                fxStruct.from_json(fx);
+                                cfg.effects.emplace_back(move(fxStruct));
+                            } else {
+                                diag(DiagCode::InvalidEntry, configKey, "fx", fx);
+                            }
+                        }
+                    }
 
-                        configs[configKey] = cfg;
+                    // Metadata
+                    if (params.contains("sound_characteristics") && params["sound_characteristics"].is_object()) {
+                        cfg.guitarParams.soundCharacteristics.from_json(params["sound_characteristics"]);
+                        cfg.soundCharacteristics = cfg.guitarParams.soundCharacteristics;
+                    }
+                    if (params.contains("topological_metadata") && params["topological_metadata"].is_object()) {
+                        cfg.guitarParams.topologicalMetadata.from_json(params["topological_metadata"]);
+                        cfg.topologicalMetadata = cfg.guitarParams.topologicalMetadata;
                     }
-                } else {
-                    cerr << "[TypeError] 'groups' not an object in guitar_types." << gtype << endl;
                 }
-            }
+            });
         } else {
-            cerr << "[TypeError] 'guitar_types' not found or not an object in guitar.json" << endl;
+            diag(DiagCode::MissingSection, "guitar.json", "guitar_types", "object");
         }
     }
 
@@ -1158,17 +3464,11 @@ void interactiveMenu() {
     auto groups = groupByCategory(selectedTags);
     cout << "Grouped Categories:\n" << json(groups).dump(2) << endl;
 
-    // Suggestions (Step 3/4: scoring, selection)
-    multimap<double, string, greater<double>> scoredConfigs;
-    for (const auto& [key, cfg] : configs) {
-        double score = computeSemanticScore(cfg, selectedTags, mood, synthType);
-        scoredConfigs.insert({score, key});
-    }
+    // Suggestions (Step 3/4: scoring, selection); the session cache serves the layered output too
+    const CandidateCache& candidates = candidatesFor(selectedTags, mood, synthType);
     cout << "AI Suggestions (highest score first):\n";
-    int count = 0;
-    for (const auto& [score, key] : scoredConfigs) {
-        if (++count > 5) break; // Top 5
-        cout << "- " << key << " (score: " << score << ")\n";
+    for (const ScoredConfig* entry : candidates.top(5)) { // Top 5
+        cout << "- " << *entry->key << " (score: " << entry->score.total() << ")\n";
     }
 
     // Confirm/Save (stub; expand to generate layered config.json)
@@ -1185,84 +3485,74 @@ void interactiveMenu() {
 }
 
 json generateLayeredOutput(const vector<string>& userChoices, const string& mood, const string& synthType) {
+    const CandidateCache& candidates = candidatesFor(userChoices, mood, synthType); // Cache hit within a menu flow
+
+    // Optional base (check map or menu flag)
+    bool useBase = getUserInput("Use base instrument? [y/n]: ") == "y"; // Or from JSON via getBool("use_base", true)
+    json layered = buildLayeredOutput(candidates, mood, userChoices.at(0), useBase);
+    if (useBase && !layered.contains("base_instrument")) {
+        cerr << "[Warning] No suitable base instrument found—proceeding without." << endl;
+    }
+    if (candidates.size() < 3) {
+        cerr << "[Info] Few matches—lowered threshold to 0.5 for broader suggestions." << endl;
+    }
+    return layered;
+}
+
+/**
+ * Layered output from scored candidates. Reads only the shared configs and the given candidates and does
+ * no I/O, so batch workers can call it concurrently.
+ */
+json buildLayeredOutput(const CandidateCache& candidates, const string& mood, const string& section, bool useBase,
+                        const array<float, GainTables::LAYER_COUNT>* layerGains = nullptr) const {
     json layered = json::object();
-    vector<string> layers = {"background_texture", "ambient_pad", "supportive_harmony", "rhythmic_motion", "main_melodic", "lead_foreground"};
-    for (const string& layer : layers) {
+    for (const string& layer : GainTables::layerNames()) {
         layered["layers"][layer] = json::object(); // Object for module params
     }
 
-    // Optional base (check map or menu flag)
-    bool useBase = getUserInput("Use base instrument? [y/n]: ") == "y"; // Or from JSON via getBool("use_base", true)
     if (useBase) {
-        string baseKey;
-        double maxBaseScore = 0.0;
-        for (const auto& [key, cfg] : configs) {
-            if (cfg.instrumentType.find("guitar") != string::npos || cfg.instrumentType == "synth") { // Filter to instruments
-                double score = computeSemanticScore(cfg, userChoices, mood, synthType);
-                if (score > maxBaseScore) {
-                    maxBaseScore = score;
-                    baseKey = key;
-                }
-            }
-        }
-        if (!baseKey.empty()) {
-            layered["base_instrument"] = configs[baseKey].to_json(); // Base always optional but included if on
-        } else {
-            cerr << "[Warning] No suitable base instrument found—proceeding without." << endl;
+        auto isInstrument = [](const SoundConfig& cfg) { // Filter to instruments
+            return cfg.instrumentType.find("guitar") != string::npos || cfg.instrumentType == "synth";
+        };
+        vector<const ScoredConfig*> base = candidates.top(1, isInstrument);
+        if (!base.empty() && base[0]->score.total() > 0.0) {
+            layered["base_instrument"] = base[0]->cfg->to_json(); // Base always optional but included if on
         }
     }
 
     // Layer suggestions as additive modules (no delete; merge if override flagged)
-    multimap<double, string, greater<double>> scoredConfigs;
-    for (const auto& [key, cfg] : configs) {
-        double score = computeSemanticScore(cfg, userChoices, mood, synthType);
-        scoredConfigs.insert({score, key});
-    }
     double threshold = 0.49;
-    if (scoredConfigs.size() < 3) {
+    if (candidates.size() < 3) {
         threshold = 0.5; // Dynamic adjustment
-        cerr << "[Info] Few matches—lowered threshold to 0.5 for broader suggestions." << endl;
     }
-    for (const auto& [score, key] : scoredConfigs) {
-        if (score >= threshold) {
-            // Assign to layer based on traits (stub; real: if slow attack -> "ambient_pad")
-            string assignedLayer = "main_melodic"; // Example; expand with envelope/timbre checks
-            layered["layers"][assignedLayer] = configs[key].to_json(); // Additive
-        }
+    for (const ScoredConfig* entry : candidates.aboveThreshold(threshold)) {
+        // Assign to layer based on traits; expand layerFor with envelope/timbre checks
+        layered["layers"][layerFor(*entry->cfg)] = entry->cfg->to_json(); // Additive
     }
 
-    // Apply Context-Aware Gain Balancing
-    balanceLayerGains(layered, mood, userChoices[0]); // userChoices[0] = section for context
+    // Apply Context-Aware Gain Balancing (batch callers pass gains computed for the whole chunk)
+    if (layerGains) balanceLayerGains(layered, *layerGains);
+    else balanceLayerGains(layered, mood, section);
 
     return layered;
 }
 
-void balanceLayerGains(json& layered, const string& mood, const string& section) {
-    map<string, float> baseGains = {
-        {"background_texture", 0.2f},
-        {"ambient_pad", 0.4f},
-        {"supportive_harmony", 0.5f},
-        {"rhythmic_motion", 0.6f},
-        {"main_melodic", 0.7f},
-        {"lead_foreground", 0.9f}
-    };
-    map<string, float> moodOffsets = {
-        {"calm", 0.8f}, // Softer overall
-        {"energetic", 1.2f} // Boost
-        // Add more from moods.json
-    };
-    float moodOffset = moodOffsets.count(lower(mood)) ? moodOffsets[lower(mood)] : 1.0f;
+// Layer a config is placed in by the layered output
+static const string& layerFor(const SoundConfig&) {
+    static const string MAIN_MELODIC = "main_melodic"; // Stub; real: if slow attack -> "ambient_pad"
+    return MAIN_MELODIC;
+}
 
-    map<string, float> sectionFactors = {
-        {"intro", 0.9f}, // Softer
-        {"chorus", 1.1f} // Louder
-        // Add from Synthesizer.json
-    };
-    float sectionFactor = sectionFactors.count(lower(section)) ? sectionFactors[lower(section)] : 1.0f;
+void balanceLayerGains(json& layered, const string& mood, const string& section) const {
+    balanceLayerGains(layered, gainTables.layerGains(gainTables.moodId(mood), gainTables.sectionId(section)));
+}
 
+// Apply per-layer gains (indexed like GainTables::layerNames()) to the generated modules
+void balanceLayerGains(json& layered, const array<float, GainTables::LAYER_COUNT>& layerGains) const {
     for (auto& [layer, module] : layered["layers"].items()) {
         if (module.is_object()) {
-            float gain = baseGains[layer] * moodOffset * sectionFactor;
+            optional<size_t> index = GainTables::layerIndex(layer);
+            float gain = index ? layerGains[*index] : 0.0f;
             // Transient/envelope sensitivity (stub: if fast attack, boost transient)
             if (module.contains("attack") && module["attack"] < 0.05) gain *= 1.1f; // Percussive boost
             module["layer_gain"] = gain; // Stored in map (extensible)
@@ -1273,291 +3563,620 @@ void balanceLayerGains(json& layered, const string& mood, const string& section)
 }
 
 json generateGroupedOutput(const vector<string>& userChoices) {
+    // Ranks on the tag part of the scores only, so the session's pass serves any mood/synth type
+    const CandidateCache& candidates = session.matchesTags(userChoices, profileGeneration) ? session : candidatesFor(userChoices);
     json groupedOutput = json::object();
-    for (const auto& [key, cfg] : configs) {
-        double score = computeSemanticScore(cfg, userChoices);
-        if (score >= 0.12) { // Threshold for relevance
-            groupedOutput["suggested_configs"][key] = cfg.to_json();
+    for (const ScoredConfig& entry : candidates.all()) {
+        if (entry.score.tagsOnly() >= 0.12) { // Threshold for relevance
+            groupedOutput["suggested_configs"][*entry.key] = entry.cfg->to_json();
         }
     }
     return groupedOutput;
 }
 
+// Session candidates for a query, rescoring only when the query or the profiles changed
+const CandidateCache& candidatesFor(const vector<string>& userTags, const string& mood = "", const string& synthType = "") {
+    ensureProfiles();
+    if (!session.matches(userTags, mood, synthType, profileGeneration)) {
+        session.assign(userTags, mood, synthType, profileGeneration, scoreConfigs(userTags, mood, synthType));
+    }
+    return session;
+}
+
+/**
+ * Score every config against the user's choices in one parallel pass. Results are in config key order;
+ * the per-config profiles are built once per SKD table and reused across queries.
+ */
+vector<ScoredConfig> scoreConfigs(const vector<string>& userTags, const string& mood = "", const string& synthType = "") {
+    ensureProfiles();
+    return scoreProfiles(SemanticQuery::compile(userTags, mood, synthType, *profileIndex), true);
+}
+
+/**
+ * Headless batch mode: one JSON request per line ({"section", "mood", "timbre", "instrument",
+ * "effectGroup", "synthType", "useBase"}), one layered config per output line, in input order.
+ * Requests are processed in parallel chunks and each chunk is written out before the next is read.
+ */
+void runBatch(const string& inputFile, const string& outputFile) {
+    ifstream in(inputFile);
+    if (!in) {
+        cerr << "[Warn] Couldn't open " << inputFile << endl;
+        return;
+    }
+    ofstream out(outputFile);
+    if (!out) {
+        cerr << "[Warn] Couldn't open " << outputFile << " for writing" << endl;
+        return;
+    }
+    ensureProfiles(); // Workers only read the profiles from here on
+    shared_ptr<const SkdIndex> index = profileIndex;
+
+    constexpr size_t CHUNK = 256;
+    size_t lineNo = 0, written = 0, failed = 0;
+    auto start = chrono::steady_clock::now();
+    vector<pair<size_t, string>> lines;
+    vector<string> results;
+    vector<char> ok;
+    vector<BatchRequest> requests;
+    vector<pair<GainTables::GainId, GainTables::GainId>> combos;
+    string line;
+    bool more = true;
+    while (more) {
+        lines.clear();
+        while (lines.size() < CHUNK && (more = static_cast<bool>(getline(in, line)))) {
+            ++lineNo;
+            if (line.find_first_not_of(" \t\r") != string::npos) lines.emplace_back(lineNo, line);
+        }
+        results.assign(lines.size(), string());
+        ok.assign(lines.size(), 0);
+        requests.assign(lines.size(), BatchRequest());
+        parallelFor(lines.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) ok[i] = parseBatchRequest(lines[i].first, lines[i].second, requests[i], results[i]);
+        });
+        // Gains for every (mood, section) in the chunk in one pass
+        combos.clear();
+        for (const BatchRequest& request : requests)
+            combos.emplace_back(gainTables.moodId(request.tags.at(1)), gainTables.sectionId(request.tags.at(0)));
+        GainTables::GainMatrix gains = gainTables.gains(combos);
+        parallelFor(lines.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                if (ok[i]) processBatchRequest(requests[i], gains.combo(i), *index, results[i]);
+            }
+        });
+        for (size_t i = 0; i < results.size(); ++i) {
+            out << results[i] << '\n';
+            if (!ok[i]) ++failed;
+        }
+        out.flush();
+        written += results.size();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "Batch: " << written << " request(s) from " << inputFile << " -> " << outputFile << " ("
+         << failed << " failed, " << seconds << " s)" << endl;
+}
+
     private:
 
-    void load_group(const string& file) {
-        ifstream inFile(file);
-        if (!inFile) {
-            cerr << "[Warn] Couldn't open " << file << endl;
-            return;
+    // A batch line's fields, lowercased; tags are section, mood, timbre, instrument, effect group
+    struct BatchRequest {
+        size_t lineNo = 0;
+        json request;
+        vector<string> tags = vector<string>(5);
+        string synthType;
+        bool useBase = false;
+    };
+
+    // Errors become {"error", "line"} records in `output` instead of aborting the batch
+    static bool parseBatchRequest(size_t lineNo, const string& line, BatchRequest& parsed, string& output) {
+        parsed.lineNo = lineNo;
+        parsed.request = json::parse(line, nullptr, false);
+        const json& request = parsed.request;
+        if (!request.is_object()) {
+            output = json{{"error", "request is not a JSON object"}, {"line", lineNo}}.dump();
+            return false;
         }
-        json j;
-        inFile >> j;
+        auto field = [&](const char* name) {
+            auto it = request.find(name);
+            return (it != request.end() && it->is_string()) ? lower(it->get<string>()) : string();
+        };
+        parsed.tags = {field("section"), field("mood"), field("timbre"), field("instrument"), field("effectGroup")};
+        parsed.synthType = field("synthType");
+        auto useBaseIt = request.find("useBase");
+        if (useBaseIt != request.end()) {
+            parsed.useBase = useBaseIt->is_boolean() ? useBaseIt->get<bool>() : (useBaseIt->is_string() && lower(useBaseIt->get<string>()) == "y");
+        }
+        return true;
+    }
+
+    // One parsed batch request -> one output line
+    void processBatchRequest(const BatchRequest& parsed, const array<float, GainTables::LAYER_COUNT>& layerGains,
+                             const SkdIndex& index, string& output) const {
+        const vector<string>& tags = parsed.tags;
+        CandidateCache candidates;
+        candidates.assign(tags, tags.at(1), parsed.synthType, profileGeneration,
+                          scoreProfiles(SemanticQuery::compile(tags, tags.at(1), parsed.synthType, index), false));
+        json result;
+        result["line"] = parsed.lineNo;
+        result["request"] = parsed.request;
+        result["layered_config"] = buildLayeredOutput(candidates, tags.at(1), tags.at(0), parsed.useBase, &layerGains);
+        output = result.dump();
+    }
+
+    void ensureProfiles() {
+        shared_ptr<const SkdIndex> index = currentSkdIndex();
+        if (profileIndex != index || profiles.size() != configs.size()) buildProfiles(index);
+    }
+
+    // Score the built profiles against a compiled query; parallel=false when the caller is already a worker
+    vector<ScoredConfig> scoreProfiles(const SemanticQuery& query, bool parallel) const {
+        vector<ScoredConfig> scored(profiles.size());
+        auto scoreRange = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const auto& [key, cfg, profile] = profiles[i];
+                scored[i] = {key, cfg, scoreProfile(profile, query)};
+            }
+        };
+        if (parallel) parallelFor(profiles.size(), scoreRange);
+        else scoreRange(0, profiles.size());
+        return scored;
+    }
+
+    private:
+
+    void load_group(const json& j) {
         if (!j.is_object()) {
-            cerr << "[TypeError] Expected object for group.json root, got " << j.type_name() << endl;
+            diag(DiagCode::ExpectedObject, "group.json root", "object", j.type_name());
             return;
         }
         if (j.contains("groups") && j["groups"].is_object()) {
-            for (auto& [name, group] : j["groups"].items()) {
-                string configKey = lower(name);
-                resolveAliases(group, configKey);
-                GroupConfig gCfg;
-                gCfg.from_json(group);
-                groupConfigs[configKey] = gCfg;
-
-                SoundConfig cfg;
-                cfg.instrumentType = "synth";
-                if (configs.count(configKey)) {
-                    cfg = configs[configKey]; // Merge with existing config
-                }
-
-                // Synthesis type
-                cfg.instrumentType = gCfg.synthesisType;
+            ConfigTasks tasks;
+            for (auto& [name, group] : j["groups"].items()) tasks.add(lower(name), name, group);
+            // Merge into the existing configs in place, or start new ones
+            vector<pair<SoundConfig*, GroupConfig*>> targets;
+            for (const auto& task : tasks.tasks) {
+                auto [slot, inserted] = configs.try_emplace(task.configKey);
+                if (inserted) slot->second.instrumentType = "synth";
+                targets.emplace_back(&slot->second, &groupConfigs[task.configKey]);
+            }
 
-                // Oscillator
-                if (group.contains("oscillator") && group["oscillator"].is_object()) {
-                    auto& osc = group["oscillator"];
-                    if (osc.contains("types") && osc["types"].is_array()) {
-                        cfg.oscTypes["osc1"] = getStringVec(osc["types"], configKey + ".oscillator.types");
-                    }
-                    if (osc.contains("mix_ratios") && osc["mix_ratios"].is_array()) {
-                        cfg.guitarParams.vectorParams["mix_ratios"] = getFloatVec(osc["mix_ratios"], configKey + ".oscillator.mix_ratios");
-                    }
-                    if (osc.contains("detune")) {
-                        cfg.guitarParams.floatParams["detune"] = getFlexibleFloat(osc["detune"], configKey + ".oscillator.detune");
-                    }
-                    if (osc.contains("morph_rate")) {
-                        cfg.guitarParams.stringParams["morph_rate"] = getStringOrFloat(osc["morph_rate"]);
-                    }
-                    if (osc.contains("table_index")) {
-                        cfg.guitarParams.stringParams["table_index"] = getStringOrFloat(osc["table_index"]);
+            orderedParallelFor(tasks.tasks.size(), [&](size_t t) {
+                const string& configKey = tasks.tasks[t].configKey;
+                SoundConfig& cfg = *targets[t].first;
+                for (const auto& [name, entry] : tasks.tasks[t].entries) {
+                    const json& group = *entry;
+                    GroupConfig& gCfg = *targets[t].second;
+                    gCfg = GroupConfig();
+                    gCfg.from_json(group);
+
+                    // Synthesis type
+                    cfg.instrumentType = gCfg.synthesisType;
+
+                    // Oscillator
+                    if (group.contains("oscillator") && group["oscillator"].is_object()) {
+                        auto& osc = group["oscillator"];
+                        if (osc.contains("types") && osc["types"].is_array()) {
+                            assignOscTypes(cfg.oscTypes["osc1"], getStringVec(osc["types"], configKey + ".oscillator.types"));
+                        }
+                        if (osc.contains("mix_ratios") && osc["mix_ratios"].is_array()) {
+                            cfg.guitarParams.setVector("mix_ratios", getFloatVec(osc["mix_ratios"], configKey + ".oscillator.mix_ratios"));
+                        }
+                        if (osc.contains("detune")) {
+                            cfg.guitarParams.setFloat("detune", getFlexibleFloat(osc["detune"], configKey + ".oscillator.detune"));
+                        }
+                        if (osc.contains("morph_rate")) {
+                            cfg.guitarParams.setString("morph_rate", getStringOrFloat(osc["morph_rate"]));
+                        }
+                        if (osc.contains("table_index")) {
+                            cfg.guitarParams.setString("table_index", getStringOrFloat(osc["table_index"]));
+                        }
+                        // Store other oscillator params generally
+                        gCfg.oscillator.from_json(osc); // To handle any additional like harmonics, modulation_index
+                        // Transfer to cfg.guitarParams
+                        cfg.guitarParams.mergeFrom(gCfg.oscillator);
                     }
-                    // Store other oscillator params generally
-                    gCfg.oscillator.from_json(osc); // To handle any additional like harmonics, modulation_index
-                    // Transfer to cfg.guitarParams maps
-                    for (const auto& [k, v] : gCfg.oscillator.floatParams) cfg.guitarParams.floatParams[k] = v;
-                    for (const auto& [k, v] : gCfg.oscillator.boolParams) cfg.guitarParams.boolParams[k] = v;
-                    for (const auto& [k, v] : gCfg.oscillator.stringParams) cfg.guitarParams.stringParams[k] = v;
-                    for (const auto& [k, v] : gCfg.oscillator.vectorParams) cfg.guitarParams.vectorParams[k] = v;
-                    for (const auto& [k, v] : gCfg.oscillator.stringVectorParams) cfg.guitarParams.stringVectorParams[k] = v;
-                }
 
-                // Envelope
-                if (group.contains("envelope") && group["envelope"].is_object()) {
-                    auto& e = group["envelope"];
-                    if (e.contains("type") && e["type"].is_string()) {
-                        cfg.guitarParams.stringParams["type"] = e["type"].get<string>();
-                    }
-                    if (e.contains("curve") && e["curve"].is_string()) {
-                        cfg.guitarParams.stringParams["curve"] = e["curve"].get<string>();
-                    }
-                    for (string param : {"attack", "decay", "sustain", "release", "delay", "hold"}) {
-                        if (e.contains(param)) {
-                            cfg.adsr["group"][param].from_json(e[param]);
+                    // Envelope
+                    if (group.contains("envelope") && group["envelope"].is_object()) {
+                        auto& e = group["envelope"];
+                        if (e.contains("type") && e["type"].is_string()) {
+                            cfg.guitarParams.setString("type", e["type"].get<string>());
                         }
+                        if (e.contains("curve") && e["curve"].is_string()) {
+                            cfg.guitarParams.setString("curve", e["curve"].get<string>());
+                        }
+                        for (size_t stage = 0; stage < AdsrTable::STAGE_COUNT; ++stage) {
+                            const char* param = AdsrTable::STAGE_NAMES[stage];
+                            if (e.contains(param)) {
+                                cfg.adsr.set(AdsrTable::Group, AdsrTable::Stage(stage), e[param]);
+                            }
+                        }
+                        // Transfer to cfg.guitarParams
+                        gCfg.envelope.from_json(e);
+                        cfg.guitarParams.mergeFrom(gCfg.envelope);
                     }
-                    // Transfer to cfg.guitarParams maps
-                    gCfg.envelope.from_json(e);
-                    for (const auto& [k, v] : gCfg.envelope.floatParams) cfg.guitarParams.floatParams[k] = v;
-                    for (const auto& [k, v] : gCfg.envelope.boolParams) cfg.guitarParams.boolParams[k] = v;
-                    for (const auto& [k, v] : gCfg.envelope.stringParams) cfg.guitarParams.stringParams[k] = v;
-                    for (const auto& [k, v] : gCfg.envelope.vectorParams) cfg.guitarParams.vectorParams[k] = v;
-                    for (const auto& [k, v] : gCfg.envelope.stringVectorParams) cfg.guitarParams.stringVectorParams[k] = v;
-                }
 
-                // Filter
-                if (group.contains("filter") && group["filter"].is_object()) {
-                    gCfg.filter.from_json(group["filter"]);
-                    cfg.guitarParams.floatParams["cutoff"] = gCfg.filter.getFloat("cutoff");
-                    cfg.guitarParams.floatParams["resonance"] = gCfg.filter.getFloat("resonance");
-                    cfg.guitarParams.floatParams["envelope_amount"] = gCfg.filter.getFloat("envelope_amount");
-                    cfg.guitarParams.stringParams["slope"] = gCfg.filter.getString("slope");
-                    cfg.guitarParams.stringParams["filter_type"] = gCfg.filter.getString("type");
-                    // Transfer all filter params
-                    for (const auto& [k, v] : gCfg.filter.floatParams) cfg.guitarParams.floatParams[k] = v;
-                    for (const auto& [k, v] : gCfg.filter.boolParams) cfg.guitarParams.boolParams[k] = v;
-                    for (const auto& [k, v] : gCfg.filter.stringParams) cfg.guitarParams.stringParams[k] = v;
-                    for (const auto& [k, v] : gCfg.filter.vectorParams) cfg.guitarParams.vectorParams[k] = v;
-                    for (const auto& [k, v] : gCfg.filter.stringVectorParams) cfg.guitarParams.stringVectorParams[k] = v;
-                }
+                    // Filter
+                    if (group.contains("filter") && group["filter"].is_object()) {
+                        gCfg.filter.from_json(group["filter"]);
+                        cfg.guitarParams.setFloat("cutoff", gCfg.filter.getFloat("cutoff"));
+                        cfg.guitarParams.setFloat("resonance", gCfg.filter.getFloat("resonance"));
+                        cfg.guitarParams.setFloat("envelope_amount", gCfg.filter.getFloat("envelope_amount"));
+                        cfg.guitarParams.setString("slope", gCfg.filter.getString("slope"));
+                        cfg.guitarParams.setString("filter_type", gCfg.filter.getString("type"));
+                        // Transfer all filter params
+                        cfg.guitarParams.mergeFrom(gCfg.filter);
+                    }
 
-                // Effects
-                if (group.contains("fx") && group["fx"].is_array()) {
-                    cfg.effects.clear();
-                    for (const auto& fxItem : group["fx"]) {
-                        if (fxItem.is_object()) {
-                            Fx fxStruct;
-                            fxStruct.from_json(fxItem);
-                            cfg.effects.push_back(fxStruct);
-                        } else {
-                            cerr << "[TypeError] Fx item is not an object in " << configKey << ": " << fxItem << endl;
+                    // Effects
+                    if (group.contains("fx") && group["fx"].is_array()) {
+                        cfg.effects.clear();
+                        for (const auto& fxItem : group["fx"]) {
+                            if (fxItem.is_object()) {
+                                Fx fxStruct;
+                                fxStruct.from_json(fxItem);
+                                cfg.effects.emplace_back(move(fxStruct));
+                            } else {
+                                diag(DiagCode::InvalidEntry, configKey, "fx", fxItem);
+                            }
                         }
                     }
-                }
 
-                // Metadata
-                if (group.contains("sound_characteristics") && group["sound_characteristics"].is_object()) {
-                    cfg.soundCharacteristics.from_json(group["sound_characteristics"]);
-                }
-                if (group.contains("topological_metadata") && group["topological_metadata"].is_object()) {
-                    cfg.topologicalMetadata.from_json(group["topological_metadata"]);
+                    // Metadata
+                    if (group.contains("sound_characteristics") && group["sound_characteristics"].is_object()) {
+                        cfg.soundCharacteristics.from_json(group["sound_characteristics"]);
+                    }
+                    if (group.contains("topological_metadata") && group["topological_metadata"].is_object()) {
+                        cfg.topologicalMetadata.from_json(group["topological_metadata"]);
+                    }
                 }
-
-                configs[configKey] = cfg;
-            }
+            });
         } else {
-            cerr << "[TypeError] 'groups' not found or not an object in group.json" << endl;
+            diag(DiagCode::MissingSection, "group.json", "groups", "object");
         }
     }
 
-    void load_moods(const string& file) {
-        ifstream inFile(file);
-        if (!inFile) {
-            cerr << "[Warn] Couldn't open " << file << endl;
-            return;
-        }
-        json j;
-        inFile >> j;
+    void load_moods(const json& j) {
         if (!j.is_object()) {
-            cerr << "[TypeError] Expected object for moods.json root, got " << j.type_name() << endl;
+            diag(DiagCode::ExpectedObject, "moods.json root", "object", j.type_name());
             return;
         }
         if (j.contains("moods") && j["moods"].is_array()) {
+            ConfigTasks tasks;
             for (auto& mood : j["moods"]) {
                 if (mood.is_object() && mood.contains("name") && mood["name"].is_string()) {
                     string name = lower(mood["name"].get<string>());
-                    resolveAliases(mood, name);
-                    if (configs.count(name)) {
-                        SoundConfig& cfg = configs[name];
-                        for (string param : {"attack", "decay", "sustain", "release"}) {
-                            if (mood.contains(param)) {
-                                cfg.adsr["mood"][param].from_json(mood[param]);
-                            }
-                        }
-                        cfg.emotion = name;
+                    if (mood.contains("gainOffset")) {
+                        gainTables.setMoodOffset(name, getFlexibleFloat(mood["gainOffset"], "moods." + name + ".gainOffset"));
+                    }
+                    // Every numeric range (or single value) is kept for the variation generator
+                    auto& ranges = moodRanges[name];
+                    ranges.clear();
+                    for (auto& [field, val] : mood.items()) {
+                        bool numeric = val.is_number() || (val.is_array() && val.size() == 2 && val[0].is_number() && val[1].is_number());
+                        if (!numeric || field == "gainOffset") continue;
+                        Range range;
+                        range.from_json(val);
+                        ranges.emplace_back(field, range);
                     }
+                    if (configs.count(name)) tasks.add(name, name, mood);
                 }
             }
+            vector<SoundConfig*> targets;
+            for (const auto& task : tasks.tasks) targets.push_back(&configs.find(task.configKey)->second);
+
+            orderedParallelFor(tasks.tasks.size(), [&](size_t t) {
+                SoundConfig& cfg = *targets[t];
+                for (const auto& [name, entry] : tasks.tasks[t].entries) {
+                    const json& mood = *entry;
+                    for (AdsrTable::Stage stage : AdsrTable::ENVELOPE_STAGES) {
+                        const char* param = AdsrTable::STAGE_NAMES[stage];
+                        if (mood.contains(param)) {
+                            cfg.adsr.set(AdsrTable::Mood, stage, mood[param]);
+                        }
+                    }
+                    cfg.emotion = name;
+                }
+            });
         } else {
-            cerr << "[TypeError] 'moods' not found or not an array in moods.json" << endl;
+            diag(DiagCode::MissingSection, "moods.json", "moods", "array");
         }
     }
 
-    void load_synth(const string& file) {
-        ifstream inFile(file);
-        if (!inFile) {
-            cerr << "[Warn] Couldn't open " << file << endl;
-            return;
-        }
-        json j;
-        inFile >> j;
+    void load_synth(const json& j) {
         if (!j.is_object()) {
-            cerr << "[TypeError] Expected object for Synthesizer.json root, got " << j.type_name() << endl;
+            diag(DiagCode::ExpectedObject, "Synthesizer.json root", "object", j.type_name());
             return;
         }
         if (j.contains("sections") && j["sections"].is_object()) {
+            ConfigTasks tasks;
             for (auto& [secName, sec] : j["sections"].items()) {
                 string configKey = lower(secName);
-                resolveAliases(sec, configKey);
-                SoundConfig cfg;
-                cfg.instrumentType = "synth";
-                if (configs.count(configKey)) {
-                    cfg = configs[configKey]; // Merge with existing
+                if (sec.contains("gainFactor")) {
+                    gainTables.setSectionFactor(configKey, getFlexibleFloat(sec["gainFactor"], configKey + ".gainFactor"));
                 }
+                tasks.add(configKey, secName, sec);
+            }
+            // Merge with existing configs in place, or start new ones
+            vector<SoundConfig*> targets;
+            for (const auto& task : tasks.tasks) {
+                auto [slot, inserted] = configs.try_emplace(task.configKey);
+                if (inserted) slot->second.instrumentType = "synth";
+                targets.push_back(&slot->second);
+            }
 
-                // Oscillator
-                if (sec.contains("oscillator")) {
-                    cfg.oscTypes["osc1"] = getStringVec(sec["oscillator"], configKey + ".oscillator");
-                }
+            orderedParallelFor(tasks.tasks.size(), [&](size_t t) {
+                const string& configKey = tasks.tasks[t].configKey;
+                SoundConfig& cfg = *targets[t];
+                for (const auto& [secName, entry] : tasks.tasks[t].entries) {
+                    const json& sec = *entry;
+
+                    // Oscillator
+                    if (sec.contains("oscillator")) {
+                        assignOscTypes(cfg.oscTypes["osc1"], getStringVec(sec["oscillator"], configKey + ".oscillator"));
+                    }
 
-                // ADSR
-                if (sec.contains("adsr") && sec["adsr"].is_object()) {
-                    for (string param : {"attack", "decay", "sustain", "release"}) {
-                        if (sec["adsr"].contains(param)) {
-                            cfg.adsr["synth"][param].from_json(sec["adsr"][param]);
+                    // ADSR ("adsr" in the file, canonicalized to "envelope" while parsing)
+                    if (sec.contains("envelope") && sec["envelope"].is_object()) {
+                        for (AdsrTable::Stage stage : AdsrTable::ENVELOPE_STAGES) {
+                            const char* param = AdsrTable::STAGE_NAMES[stage];
+                            if (sec["envelope"].contains(param)) {
+                                cfg.adsr.set(AdsrTable::Synth, stage, sec["envelope"][param]);
+                            }
                         }
                     }
-                }
 
-                // Effects
-                if (sec.contains("fx") && sec["fx"].is_array()) {
-                    for (const auto& fx : sec["fx"]) {
-                        Fx fxStruct;
-                        fxStruct.from_json(fx);
-                        cfg.effects.push_back(fxStruct);
+                    // Effects
+                    if (sec.contains("fx") && sec["fx"].is_array()) {
+                        for (const auto& fx : sec["fx"]) {
+                            Fx fxStruct;
+                            fxStruct.from_json(fx);
+                            cfg.effects.emplace_back(move(fxStruct));
+                        }
                     }
-                }
 
-                // Metadata
-                if (sec.contains("emotion") && sec["emotion"].is_string()) {
-                    cfg.emotion = sec["emotion"].get<string>();
-                }
-                if (sec.contains("topology") && sec["topology"].is_string()) {
-                    cfg.topology = sec["topology"].get<string>();
-                }
-                if (sec.contains("sound_characteristics") && sec["sound_characteristics"].is_object()) {
-                    cfg.soundCharacteristics.from_json(sec["sound_characteristics"]);
-                }
-                if (sec.contains("topological_metadata") && sec["topological_metadata"].is_object()) {
-                    cfg.topologicalMetadata.from_json(sec["topological_metadata"]);
+                    // Metadata
+                    if (sec.contains("emotion") && sec["emotion"].is_string()) {
+                        cfg.emotion = sec["emotion"].get<string>();
+                    }
+                    if (sec.contains("topology") && sec["topology"].is_string()) {
+                        cfg.topology = sec["topology"].get<string>();
+                    }
+                    if (sec.contains("sound_characteristics") && sec["sound_characteristics"].is_object()) {
+                        cfg.soundCharacteristics.from_json(sec["sound_characteristics"]);
+                    }
+                    if (sec.contains("topological_metadata") && sec["topological_metadata"].is_object()) {
+                        cfg.topologicalMetadata.from_json(sec["topological_metadata"]);
+                    }
                 }
+            });
+        } else {
+            diag(DiagCode::MissingSection, "Synthesizer.json", "sections", "object");
+        }
+    }
 
-                configs[configKey] = cfg;
+    /**
+     * Ranged parameters of a config for the variation generator: ADSR ranges per context, the numeric
+     * ranges of every mood listed in its emotion, "_range" vectors in its params, and two-value FX
+     * params. Fixed values (min == max) are left out. Params with a ParamMeta range are clamped to it.
+     */
+    VariationPlan variationPlan(const SoundConfig& cfg) const {
+        VariationPlan plan;
+        cfg.adsr.forEach([&](AdsrTable::Context context, AdsrTable::Stage stage, const Range& range) {
+            if (range.min != range.max) {
+                plan.add(string("adsr.") + AdsrTable::CONTEXT_NAMES[context] + "." + AdsrTable::STAGE_NAMES[stage], range.min, range.max);
             }
-        } else {
-            cerr << "[TypeError] 'sections' not found or not an object in Synthesizer.json" << endl;
+        });
+        for (string mood : split(lower(cfg.emotion), ',')) { // "calm, reflective"
+            mood.erase(0, mood.find_first_not_of(' '));
+            auto it = moodRanges.find(mood);
+            if (it == moodRanges.end()) continue;
+            for (const auto& [field, range] : it->second) {
+                if (range.min != range.max) plan.add("mood." + it->first + "." + field, range.min, range.max);
+            }
+        }
+        auto addVectorRanges = [&](const BaseParamStruct& params, const string& prefix, const string& type, bool anyPair) {
+            params.forEachFloatVector([&](const string& key, const vector<float>& v) {
+                bool isRange = anyPair || (key.size() > 6 && key.compare(key.size() - 6, 6, "_range") == 0);
+                if (v.size() != 2 || v[0] == v[1] || !isRange) return;
+                plan.add(prefix + key, v[0], v[1], metaClamp(params.scopeName(), type, key));
+            });
+        };
+        addVectorRanges(cfg.guitarParams, "guitarParams.", "", false);
+        for (size_t i = 0; i < cfg.effects.size(); ++i) {
+            const Fx& fx = cfg.effects[i];
+            addVectorRanges(fx, "fx[" + to_string(i) + "]." + fx.type + ".", fx.type, true);
         }
+        return plan;
     }
 
-    void load_structure(const string& file) {
-        ifstream inFile(file);
-        if (!inFile) {
-            cerr << "[Warn] Couldn't open " << file << endl;
-            return;
+    // [min, max] of the registered (or loaded, non-discovered) ParamMeta for a key, if it has one
+    static optional<pair<float, float>> metaClamp(const string& scope, const string& type, const string& key) {
+        shared_ptr<const SchemaSnapshot> snapshot = SchemaRegistry::current();
+        const ParamMeta* meta = type.empty() ? nullptr : snapshot->registeredParam(type, key);
+        if (!meta) {
+            if (const map<string, ParamMeta>* schema = snapshot->scope(scope)) {
+                auto it = schema->find(key);
+                if (it != schema->end() && !it->second.discovered) meta = &it->second;
+            }
         }
-        json j;
-        inFile >> j;
+        if (!meta || meta->minVal >= meta->maxVal) return nullopt;
+        return make_pair(meta->minVal, meta->maxVal);
+    }
+
+    // One file's entries grouped per target config for the parallel loaders. Entries that land on the
+    // same config share a task, so they still apply in file order; tasks keep first-occurrence order.
+    struct ConfigTasks {
+        struct Task {
+            string configKey;
+            vector<pair<string, const json*>> entries; // (entry name, entry)
+        };
+        vector<Task> tasks;
+        unordered_map<string, size_t> index;
+
+        void add(const string& configKey, const string& name, const json& entry) {
+            auto [it, inserted] = index.try_emplace(configKey, tasks.size());
+            if (inserted) tasks.push_back({configKey, {}});
+            tasks[it->second].entries.emplace_back(name, &entry);
+        }
+    };
+
+    // One structure.json section entry: the config it names and the overrides it carries
+    struct StructureSection {
+        string name;
+        string configKey;
+        optional<bool> useDynamicGate;
+        optional<float> gateThreshold, gateDecaySec;
+        array<optional<float>, EffectiveParamRow::STAGE_COUNT> stageMul;
+    };
+
+    /**
+     * Build the effective-parameter table: per (config, section), each ADSR stage from the most
+     * specific context that defines it (synth, then mood, group, osc) scaled by the
+     * section's multiplier, the section's gate settings over the config's, and the config's layer gain.
+     */
+    void resolveEffectiveParams(const vector<StructureSection>& sections) {
+        static constexpr array<AdsrTable::Context, AdsrTable::CONTEXT_COUNT> CONTEXT_PRECEDENCE = {
+            AdsrTable::Synth, AdsrTable::Mood, AdsrTable::Group, AdsrTable::Osc};
+        vector<const string*> keys;
+        keys.reserve(configs.size());
+        for (const auto& [key, cfg] : configs) keys.push_back(&key);
+        vector<string> names;
+        names.reserve(sections.size());
+        for (const StructureSection& section : sections) names.push_back(section.name);
+        effectiveParams.reset(move(keys), names);
+
+        for (const StructureSection& section : sections) {
+            uint32_t configId = *effectiveParams.configId(section.configKey);
+            uint32_t sectionId = *effectiveParams.sectionId(section.name);
+            EffectiveParamRow* added = effectiveParams.addRow(configId, sectionId);
+            if (!added) {
+                diag(DiagCode::DuplicateSection, "structure.json", section.name, section.configKey);
+                continue;
+            }
+            EffectiveParamRow& row = *added;
+            const SoundConfig& cfg = configs.find(section.configKey)->second;
+
+            for (size_t stage = 0; stage < EffectiveParamRow::STAGE_COUNT; ++stage) {
+                AdsrTable::Stage adsrStage = AdsrTable::ENVELOPE_STAGES[stage];
+                auto context = find_if(CONTEXT_PRECEDENCE.begin(), CONTEXT_PRECEDENCE.end(),
+                                       [&](AdsrTable::Context c) { return cfg.adsr.has(c, adsrStage); });
+                if (context == CONTEXT_PRECEDENCE.end()) continue;
+                Range range = cfg.adsr.get(*context, adsrStage);
+                float mul = section.stageMul[stage].value_or(1.0f);
+                row.stageMin[stage] = range.min * mul;
+                row.stageMax[stage] = range.max * mul;
+                row.flags |= 1u << stage;
+            }
+            if (section.useDynamicGate.value_or(cfg.useDynamicGate)) row.flags |= EffectiveParamRow::DYNAMIC_GATE;
+            row.gateThreshold = section.gateThreshold.value_or(cfg.gateThreshold);
+            row.gateDecaySec = section.gateDecaySec.value_or(cfg.gateDecaySec);
+            row.layerGain = gainTables.gain(layerFor(cfg), cfg.emotion, section.name);
+        }
+    }
+
+    // Runs serially: sections that share a config compound their multipliers in file order
+    void load_structure(const json& j) {
         if (!j.is_object()) {
-            cerr << "[TypeError] Expected object for structure.json root, got " << j.type_name() << endl;
+            diag(DiagCode::ExpectedObject, "structure.json root", "object", j.type_name());
             return;
         }
         if (j.contains("sections") && j["sections"].is_array()) {
+            vector<StructureSection> sections;
             for (const auto& sec : j["sections"]) {
                 if (sec.is_object() && sec.contains("group") && sec["group"].is_string()) {
                     string configKey = lower(sec["group"].get<string>());
-                    resolveAliases((json&)sec, configKey);
                     if (!configs.count(configKey)) {
-                        cerr << "[Warn] Structure section group '" << configKey << "' not found in configs, skipping\n";
+                        diag(DiagCode::GroupNotFound, "structure.json", configKey);
                         continue;
                     }
-                    SoundConfig& cfg = configs[configKey];
+                    StructureSection section;
+                    section.configKey = configKey;
+                    section.name = sec.contains("sectionName") && sec["sectionName"].is_string()
+                                       ? sec["sectionName"].get<string>()
+                                       : "section_" + to_string(sections.size());
                     if (sec.contains("useDynamicGate") && sec["useDynamicGate"].is_boolean()) {
-                        cfg.useDynamicGate = sec["useDynamicGate"].get<bool>();
+                        section.useDynamicGate = sec["useDynamicGate"].get<bool>();
                     }
                     if (sec.contains("gateThreshold")) {
-                        cfg.gateThreshold = getFlexibleFloat(sec["gateThreshold"], configKey + ".gateThreshold");
+                        section.gateThreshold = getFlexibleFloat(sec["gateThreshold"], configKey + ".gateThreshold");
                     }
                     if (sec.contains("gateDecaySec")) {
-                        cfg.gateDecaySec = getFlexibleFloat(sec["gateDecaySec"], configKey + ".gateDecaySec");
+                        section.gateDecaySec = getFlexibleFloat(sec["gateDecaySec"], configKey + ".gateDecaySec");
                     }
-                    // Apply multipliers to ADSR
-                    for (string param : {"attack", "decay", "sustain", "release"}) {
-                        string mulKey = param + "Mul";
+                    for (size_t stage = 0; stage < EffectiveParamRow::STAGE_COUNT; ++stage) {
+                        string mulKey = string(AdsrTable::STAGE_NAMES[AdsrTable::ENVELOPE_STAGES[stage]]) + "Mul";
                         if (sec.contains(mulKey)) {
-                            float mul = getFlexibleFloat(sec[mulKey], configKey + "." + mulKey);
-                            for (auto& [context, params] : cfg.adsr) {
-                                if (params.find(param) != params.end()) {
-                                    params[param].min *= mul;
-                                    params[param].max *= mul;
-                                }
-                            }
+                            section.stageMul[stage] = getFlexibleFloat(sec[mulKey], configKey + "." + mulKey);
                         }
                     }
+                    sections.push_back(move(section));
+                }
+            }
+
+            // Rows resolve against the configs as loaded, before the in-place edits below
+            resolveEffectiveParams(sections);
+
+            for (const StructureSection& section : sections) {
+                SoundConfig& cfg = configs.find(section.configKey)->second;
+                if (section.useDynamicGate) cfg.useDynamicGate = *section.useDynamicGate;
+                if (section.gateThreshold) cfg.gateThreshold = *section.gateThreshold;
+                if (section.gateDecaySec) cfg.gateDecaySec = *section.gateDecaySec;
+                // Apply multipliers to ADSR: one flat pass over every context, 1 for stages the section leaves alone
+                array<float, AdsrTable::STAGE_COUNT> mul;
+                mul.fill(1.0f);
+                bool anyMul = false;
+                for (size_t stage = 0; stage < EffectiveParamRow::STAGE_COUNT; ++stage) {
+                    if (!section.stageMul[stage]) continue;
+                    mul[AdsrTable::ENVELOPE_STAGES[stage]] = *section.stageMul[stage];
+                    anyMul = true;
                 }
+                if (anyMul) cfg.adsr.scale(mul);
             }
         } else {
-            cerr << "[TypeError] 'sections' not found or not an array in structure.json" << endl;
+            diag(DiagCode::MissingSection, "structure.json", "sections", "array");
+        }
+    }
+
+    // Per registered FX type: instance count and mean of each slot, computed over FxBatch columns
+    void reportRegisteredEffects() {
+        vector<Fx*> allEffects;
+        for (auto& [key, cfg] : configs) {
+            for (Fx& fx : cfg.effects) allEffects.push_back(&fx);
+        }
+        shared_ptr<const SchemaSnapshot> snapshot = SchemaRegistry::current();
+        for (const auto& [type, layout] : snapshot->layouts) {
+            FxBatch batch = FxBatch::gather(type, allEffects);
+            cerr << "[Info] Registered FX '" << type << "': " << batch.members.size() << " instance(s)";
+            for (uint32_t s = 0; s < layout->names.size(); ++s) {
+                size_t count = 0;
+                float avg = batch.mean(ParamHandle{layout.get(), s}, &count);
+                cerr << ", " << layout->names[s] << " mean " << avg << " (" << count << " set)";
+            }
+            cerr << endl;
+        }
+    }
+
+    // Container allocations per loaded config: requests that would each have hit the heap without
+    // the pool, against the heap allocations the pool actually made (plus every heap allocation of
+    // the load in a COUNT_HEAP_ALLOCATIONS build)
+    void reportAllocations() const {
+        if (configs.empty()) return;
+        double perConfig = 1.0 / configs.size();
+        cerr << "[Info] Loader allocations for " << configs.size() << " config(s): ";
+        if (HeapStats::enabled) {
+            cerr << loadHeapAllocations << " heap allocations parsing and merging (" << loadHeapAllocations * perConfig
+                 << " per config, " << loadHeapBytes << " bytes); config pool: ";
         }
+        cerr << poolCounter.allocations() << " container requests (" << poolCounter.allocations() * perConfig
+             << " per config), " << heapCounter.allocations() << " heap allocations via pool ("
+             << heapCounter.allocations() * perConfig << " per config, " << heapCounter.bytes() << " bytes)" << endl;
+    }
+
+    void reportEffectiveParams() const {
+        const auto& rows = effectiveParams.allRows();
+        size_t gated = count_if(rows.begin(), rows.end(), [](const EffectiveParamRow& row) { return row.dynamicGate(); });
+        cerr << "[Info] Effective param table: " << rows.size() << " row(s) over " << effectiveParams.sectionCount()
+             << " section(s), " << gated << " gated, " << rows.size() * sizeof(EffectiveParamRow) << " bytes" << endl;
     }
 
     void reportLoaded(const string& key) const {
@@ -1565,7 +4184,7 @@ json generateGroupedOutput(const vector<string>& userChoices) {
         cout << "Report for " << key << " (" << cfg.instrumentType << "):" << endl;
         cout << "  Loaded params (guitarParams): " << json(cfg.guitarParams.getAllParamKeys()).dump() << endl;
         cout << "  Loaded oscTypes: " << json(cfg.oscTypes).dump() << endl;
-        cout << "  Loaded ADSR: " << json(cfg.adsr).dump() << endl;
+        cout << "  Loaded ADSR: " << cfg.adsr.to_json().dump() << endl;
         cout << "  Loaded effects count: " << cfg.effects.size() << endl;
         cout << "  Loaded emotion: " << cfg.emotion << endl;
         cout << "  Loaded topology: " << cfg.topology << endl;
@@ -1574,58 +4193,271 @@ json generateGroupedOutput(const vector<string>& userChoices) {
         // Extend with missing/unhandled from schema comparisons (already logged in paramsFromJson)
     }
 
+    // Full document as one json tree; the reference the streaming writer is checked against
+    json buildConfigJson() const {
+        json output = json::object();
+        json guitar = json::object();
+        json group = json::object();
+        json synth = json::object();
+        json schemaSection = json::object();
+
+        // Collect global schema
+        shared_ptr<const SchemaSnapshot> schemaSnapshot = SchemaRegistry::current();
+        for (const auto& [type, schema] : schemaSnapshot->registered) {
+            // Serialize schema: convert each ParamMeta map to json
+            json typeSchemaJson = json::object();
+            for (const auto& [param, meta] : schema) {
+                typeSchemaJson[param] = meta.to_json();
+            }
+            schemaSection[type] = typeSchemaJson;
+        }
+        schemaSection["version"] = schemaSnapshot->version;
+
+        // Main configs
+        for (const auto& [key, cfg] : configs) {
+            json cfgJson = cfg.to_json();  // No embedded schema here!
+            switch (sectionOf(key, cfg)) {
+                case SaveSection::Guitar: guitar[key] = cfgJson; break;
+                case SaveSection::Group: group[key] = cfgJson; break;
+                case SaveSection::Synth: synth[key] = cfgJson; break;
+                default: output[key] = cfgJson; // Fallback
+            }
+        }
+
+        if (!guitar.empty()) output["guitar"] = guitar;
+        if (!group.empty()) output["group"] = group;
+        if (!synth.empty()) output["synthesizer"] = synth;
+        output["schema"] = schemaSection; // Only one global schema at the root
+        return output;
+    }
+
+    /**
+     * Stream the document buildConfigJson() describes: one pass sorts config pointers into their
+     * sections, then each section is written config by config from the structs themselves.
+     * Top-level and schema keys are merged in sorted order so JSON output matches dump() exactly.
+     */
+    void writeConfig(ConfigWriter& w) const {
+        array<vector<pair<const string*, const SoundConfig*>>, 4> sections; // Indexed by SaveSection
+        for (const auto& [key, cfg] : configs) {
+            sections[static_cast<size_t>(sectionOf(key, cfg))].emplace_back(&key, &cfg);
+        }
+
+        static const string GUITAR = "guitar", GROUP = "group", SYNTH = "synthesizer", SCHEMA = "schema";
+        vector<pair<const string*, int>> topLevel; // Section index, or -1 for a fallback config
+        if (!sections[0].empty()) topLevel.emplace_back(&GUITAR, 0);
+        if (!sections[1].empty()) topLevel.emplace_back(&GROUP, 1);
+        if (!sections[2].empty()) topLevel.emplace_back(&SYNTH, 2);
+        topLevel.emplace_back(&SCHEMA, 3);
+        size_t namedSections = topLevel.size();
+        for (const auto& [key, cfg] : sections[3]) {
+            // A section with the same name replaces the fallback entry in the tree version
+            bool shadowed = any_of(topLevel.begin(), topLevel.begin() + namedSections,
+                                   [&](const auto& entry) { return *entry.first == *key; });
+            if (!shadowed) topLevel.emplace_back(key, -1);
+        }
+        sort(topLevel.begin(), topLevel.end(), [](const auto& a, const auto& b) { return *a.first < *b.first; });
+
+        size_t fallbackIndex = 0;
+        w.beginObject();
+        for (const auto& [name, section] : topLevel) {
+            w.key(*name);
+            if (section == -1) {
+                while (sections[3][fallbackIndex].first != name) ++fallbackIndex;
+                sections[3][fallbackIndex].second->write(w);
+            } else if (section == 3) {
+                writeSchema(w);
+            } else {
+                w.beginObject();
+                for (const auto& [key, cfg] : sections[section]) {
+                    w.key(*key);
+                    cfg->write(w);
+                }
+                w.endObject();
+            }
+        }
+        w.endObject();
+    }
+
     void saveConfig(const string& filename) {
-    json output = json::object();
-    json guitar = json::object();
-    json group = json::object();
-    json synth = json::object();
-    json schemaSection = json::object();
-
-    // Collect global schema
-    for (const auto& [type, schema] : BaseParamStruct::registeredSchemas) {
-        // Serialize schema: convert each ParamMeta map to json
-        json typeSchemaJson = json::object();
-        for (const auto& [param, meta] : schema) {
-            typeSchemaJson[param] = meta.to_json();
-        }
-        schemaSection[type] = typeSchemaJson;
-    }
-    schemaSection["version"] = BaseParamStruct::schemaVersion;
-
-    // Main configs
-    for (const auto& [key, cfg] : configs) {
-        json cfgJson = cfg.to_json();  // No embedded schema here!
-        if (cfg.instrumentType.find("guitar") != string::npos) {
-            guitar[key] = cfgJson;
-        } else if (cfg.instrumentType == "synth" && (key.find("pad_") != string::npos || key.find("bass_") != string::npos)) {
-            group[key] = cfgJson;
-        } else if (cfg.instrumentType == "synth") {
-            synth[key] = cfgJson;
+        ofstream file(filename, saveFormat == SaveFormat::Cbor ? ios::binary : ios::out);
+        if (file) {
+            ConfigWriter writer(file, saveFormat);
+            writeConfig(writer);
+            writer.flush();
+            file.close();
+            cout << "Configuration saved to " << filename << " with grouped sections and a single top-level schema." << endl;
         } else {
-            output[key] = cfgJson; // Fallback
+            cerr << "Failed to save configuration to " << filename << endl;
         }
     }
 
-    if (!guitar.empty()) output["guitar"] = guitar;
-    if (!group.empty()) output["group"] = group;
-    if (!synth.empty()) output["synthesizer"] = synth;
-    output["schema"] = schemaSection; // Only one global schema at the root
-
-    ofstream file(filename);
-    if (file) {
-        file << output.dump(4);
-        file.close();
-        cout << "Configuration saved to " << filename << " with grouped sections and a single top-level schema." << endl;
-    } else {
-        cerr << "Failed to save configuration to " << filename << endl;
-      }
-   }
 };
 
-int main() {
+/**
+ * --bench-units: time the unit-table parser against the legacy find/stof version on a mix of values
+ * shaped like the presets (ADSR times, filter cutoffs, keywords, plain numbers), scalar and batch.
+ */
+void runUnitParserBenchmark(size_t iterations) {
+    const json corpus = {"600ms", "3s", "800Hz", "1500ms", "0.35", "2.5s", "12000Hz", "AI-driven", "5ms", "440Hz",
+                         0.75, "10s", "random", "250ms", "-0.5", "120Hz"};
+    using clock = chrono::steady_clock;
+    volatile float sink = 0.0f;
+
+    // Both parsers must agree on the units the legacy one understood
+    size_t mismatches = 0;
+    for (const auto& v : corpus) {
+        if (legacyFlexibleFloat(v) != parseFlexible(v).value) ++mismatches;
+    }
+
+    auto start = clock::now();
+    for (size_t it = 0; it < iterations; ++it)
+        for (const auto& v : corpus) sink = sink + legacyFlexibleFloat(v);
+    double legacyNs = chrono::duration<double, nano>(clock::now() - start).count();
+
+    start = clock::now();
+    for (size_t it = 0; it < iterations; ++it)
+        for (const auto& v : corpus) sink = sink + parseFlexible(v).value;
+    double scalarNs = chrono::duration<double, nano>(clock::now() - start).count();
+
+    vector<float> batch;
+    batch.reserve(corpus.size());
+    start = clock::now();
+    for (size_t it = 0; it < iterations; ++it) {
+        batch.clear();
+        parseUnitFloats(corpus, batch);
+        sink = sink + batch[0];
+    }
+    double batchNs = chrono::duration<double, nano>(clock::now() - start).count();
+
+    double values = static_cast<double>(iterations * corpus.size());
+    cout << "Unit parser benchmark (" << iterations << " x " << corpus.size() << " values)" << endl;
+    cout << "  legacy find/stof : " << legacyNs / values << " ns/value" << endl;
+    cout << "  from_chars table : " << scalarNs / values << " ns/value (" << legacyNs / scalarNs << "x)" << endl;
+    cout << "  batch array API  : " << batchNs / values << " ns/value (" << legacyNs / batchNs << "x)" << endl;
+    cout << "  mismatches on legacy units: " << mismatches << endl;
+}
+
+// Whole-argument unsigned integer; nullopt for a sign, trailing junk or overflow
+optional<uint64_t> parseCountArg(const char* text) {
+    const char* end = text + strlen(text);
+    uint64_t value = 0;
+    auto [ptr, ec] = from_chars(text, end, value);
+    if (ec != errc() || ptr != end || ptr == text) return nullopt;
+    return value;
+}
+
+int main(int argc, char* argv[]) {
+    // Diagnostics options: --diag-format text|json, --diag-level info|warning|error, --diag-out <file>
+    // --aliases <file> adds user key aliases; --bench-units [iterations] runs the numeric parser benchmark and exits
+    // --batch <requests.jsonl> [--batch-out <file>] generates layered configs headlessly instead of the menu
+    // --save-format pretty|compact|cbor picks the config encoding; --bench-save [iterations] times saving and exits
+    // --variations <n> [--variation-out <file>] [--variation-format jsonl|binary] [--variation-seed <n>]
+    //   [--variation-config <key>] writes n sampled presets per config and exits
+    Diagnostics& diagnostics = Diagnostics::instance();
+    string batchInput, batchOutput = "layered_configs.jsonl";
+    SaveFormat saveFormat = SaveFormat::Pretty;
+    size_t benchSaveIterations = 0;
+    size_t variationCount = 0;
+    string variationOutput, variationConfig;
+    VariationFormat variationFormat = VariationFormat::Jsonl;
+    uint64_t variationSeed = 1;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--diag-format" && i + 1 < argc) {
+            string f = argv[++i];
+            if (f == "json") diagnostics.setFormat(Diagnostics::Format::Json);
+            else if (f == "text") diagnostics.setFormat(Diagnostics::Format::Text);
+            else cerr << "[Warn] Unknown diagnostics format '" << f << "'—using text." << endl;
+        } else if (arg == "--diag-level" && i + 1 < argc) {
+            string level = argv[++i];
+            if (auto severity = parseSeverity(level)) diagnostics.setMinSeverity(*severity);
+            else cerr << "[Warn] Unknown diagnostics level '" << level << "'—using info." << endl;
+        } else if (arg == "--diag-out" && i + 1 < argc) {
+            diagnostics.setOutputFile(argv[++i]);
+        } else if (arg == "--batch" && i + 1 < argc) {
+            batchInput = argv[++i];
+        } else if (arg == "--batch-out" && i + 1 < argc) {
+            batchOutput = argv[++i];
+        } else if (arg == "--save-format" && i + 1 < argc) {
+            string f = argv[++i];
+            if (auto format = parseSaveFormat(f)) saveFormat = *format;
+            else cerr << "[Warn] Unknown save format '" << f << "'—using pretty." << endl;
+        } else if (arg == "--bench-save") {
+            benchSaveIterations = 200;
+            if (i + 1 < argc && isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+                optional<uint64_t> n = parseCountArg(argv[++i]);
+                if (!n) {
+                    cerr << "Usage: --bench-save [iterations], got '" << argv[i] << "'" << endl;
+                    return 1;
+                }
+                benchSaveIterations = *n;
+            }
+        } else if (arg == "--variations" && i + 1 < argc) {
+            optional<uint64_t> n = parseCountArg(argv[++i]);
+            if (!n) {
+                cerr << "Usage: --variations <n> expects a non-negative integer, got '" << argv[i] << "'" << endl;
+                return 1;
+            }
+            variationCount = *n;
+        } else if (arg == "--variation-out" && i + 1 < argc) {
+            variationOutput = argv[++i];
+        } else if (arg == "--variation-format" && i + 1 < argc) {
+            string f = argv[++i];
+            if (f == "binary") variationFormat = VariationFormat::Binary;
+            else if (f == "jsonl") variationFormat = VariationFormat::Jsonl;
+            else cerr << "[Warn] Unknown variation format '" << f << "'—using jsonl." << endl;
+        } else if (arg == "--variation-seed" && i + 1 < argc) {
+            optional<uint64_t> seed = parseCountArg(argv[++i]);
+            if (!seed) {
+                cerr << "Usage: --variation-seed <n> expects a non-negative integer, got '" << argv[i] << "'" << endl;
+                return 1;
+            }
+            variationSeed = *seed;
+        } else if (arg == "--variation-config" && i + 1 < argc) {
+            variationConfig = argv[++i];
+        } else if (arg == "--aliases" && i + 1 < argc) {
+            FieldAliases::instance().load(argv[++i]);
+        } else if (arg == "--bench-units") {
+            size_t iterations = 200000;
+            if (i + 1 < argc && isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+                optional<uint64_t> n = parseCountArg(argv[++i]);
+                if (!n) {
+                    cerr << "Usage: --bench-units [iterations], got '" << argv[i] << "'" << endl;
+                    return 1;
+                }
+                iterations = *n;
+            }
+            runUnitParserBenchmark(iterations);
+            return 0;
+        } else {
+            cerr << "[Warn] Ignoring unknown argument '" << arg << "'" << endl;
+        }
+    }
+
     srand(time(nullptr));
     SoundEngineeringQueue queue;
+    queue.setSaveFormat(saveFormat);
+    if (benchSaveIterations > 0) {
+        queue.loadAndMerge(false);
+        queue.benchmarkSave(benchSaveIterations);
+        diagnostics.flush();
+        return 0;
+    }
+    if (variationCount > 0) {
+        if (variationOutput.empty()) variationOutput = variationFormat == VariationFormat::Binary ? "variations.bin" : "variations.jsonl";
+        queue.loadAndMerge(false);
+        queue.generateVariations(variationCount, variationOutput, variationFormat, variationSeed, variationConfig);
+        diagnostics.flush();
+        return 0;
+    }
+    if (!batchInput.empty()) {
+        queue.loadAndMerge(false);
+        queue.runBatch(batchInput, batchOutput);
+        diagnostics.flush();
+        return 0;
+    }
     queue.loadAndMerge();
     queue.interactiveMenu();
+    diagnostics.flush(); // Anything recorded while generating output
     return 0;
 }
\ No newline at end of file
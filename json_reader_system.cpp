@@ -7,6 +7,15 @@
 #include <set>
 #include <algorithm>
 #include <optional>
+#include <filesystem>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <charconv>
+#include <system_error>
+#include <functional>
+#include <memory>
+#include <stdexcept>
 
 using namespace std;
 using json = nlohmann::json;
@@ -40,6 +49,12 @@ struct SectionMapping {
     float gateDecaySec = 0.0f;
 };
 
+// Encoding of the delta written next to a new clean_config generation
+enum class PatchFormat {
+    Json,  // RFC 6902 JSON Patch array
+    Cbor   // The same patch array, CBOR-encoded
+};
+
 // Main JSON Reader System class
 class JsonReaderSystem {
 private:
@@ -54,6 +69,14 @@ private:
     // Internal AI scoring data (not exported)
     map<string, int> layeringRoles;  // 1-6 layering stages (internal only)
     map<string, float> aiScores;     // AI matching scores (internal only)
+    
+    optional<PatchFormat> patchFormat;  // Set: also write a patch from the previous generation
+    
+    // A previous clean_config generation: per-instrument body hashes, bodies read on demand
+    struct Generation {
+        map<string, uint64_t> hashes;
+        function<json(const string&)> body;
+    };
 
 public:
     // Load all JSON files
@@ -312,6 +335,213 @@ private:
         return result;
     }
     
+    // FNV-1a over the CBOR encoding: a structural hash that ignores formatting
+    static uint64_t bodyHash(const json& body) {
+        uint64_t hash = 14695981039346656037ull;
+        for (uint8_t byte : json::to_cbor(body)) {
+            hash = (hash ^ byte) * 1099511628211ull;
+        }
+        return hash;
+    }
+    
+    static string hashHex(uint64_t hash) {
+        char text[17];
+        snprintf(text, sizeof(text), "%016llx", (unsigned long long)hash);
+        return text;
+    }
+    
+    // Instrument name as a JSON Pointer reference token ("~" -> "~0", "/" -> "~1")
+    static string pointerToken(const string& name) {
+        string token;
+        for (char c : name) {
+            if (c == '~') token += "~0";
+            else if (c == '/') token += "~1";
+            else token += c;
+        }
+        return token;
+    }
+    
+    // "clean_config.json" / "clean_config.manifest.json" -> "clean_config.patch.json" (or .patch.cbor)
+    string patchPathFor(const string& outputPath) const {
+        string base = outputPath;
+        for (const string suffix : {".manifest.json", ".json"}) {
+            if (base.size() > suffix.size() && base.compare(base.size() - suffix.size(), suffix.size(), suffix) == 0) {
+                base.erase(base.size() - suffix.size());
+                break;
+            }
+        }
+        return base + (*patchFormat == PatchFormat::Cbor ? ".patch.cbor" : ".patch.json");
+    }
+    
+    // Previous monolithic generation, if the output file already exists
+    static optional<Generation> previousMonolithic(const string& filename) {
+        ifstream previousFile(filename);
+        if (!previousFile) return nullopt;
+        auto previous = make_shared<json>();
+        try {
+            previousFile >> *previous;
+        } catch (const exception& e) {
+            cerr << "Ignoring unreadable previous " << filename << ": " << e.what() << endl;
+            return nullopt;
+        }
+        
+        Generation generation;
+        for (const auto& [name, body] : previous->items()) {
+            generation.hashes[name] = bodyHash(body);
+        }
+        generation.body = [previous](const string& name) { return previous->value(name, json()); };
+        return generation;
+    }
+    
+    // Previous sharded generation: hashes come from the manifest, so an unchanged instrument's
+    // shard is never opened; changed ones read their old shard on first use
+    static optional<Generation> previousSharded(const string& manifestPath) {
+        ifstream manifestFile(manifestPath);
+        if (!manifestFile) return nullopt;
+        json manifest;
+        try {
+            manifestFile >> manifest;
+        } catch (const exception& e) {
+            cerr << "Ignoring unreadable previous " << manifestPath << ": " << e.what() << endl;
+            return nullopt;
+        }
+        if (!manifest.contains("instruments") || !manifest["instruments"].is_object()) return nullopt;
+        
+        filesystem::path shardRoot = filesystem::path(manifestPath).parent_path() /
+                                     manifest.value("shardDir", "clean_config_shards");
+        auto shardOf = make_shared<map<string, string>>();
+        auto openShards = make_shared<map<string, json>>();
+        auto readBody = [shardRoot, shardOf, openShards](const string& name) {
+            auto it = shardOf->find(name);
+            if (it == shardOf->end()) return json();
+            auto [shard, inserted] = openShards->try_emplace(it->second, json::object());
+            if (inserted) {
+                ifstream shardFile(shardRoot / it->second);
+                try {
+                    if (shardFile) shardFile >> shard->second;
+                } catch (const exception& e) {
+                    cerr << "Error reading previous shard " << it->second << ": " << e.what() << endl;
+                }
+            }
+            return shard->second.value(name, json());
+        };
+        
+        Generation generation;
+        generation.body = readBody;
+        for (const auto& [name, info] : manifest["instruments"].items()) {
+            (*shardOf)[name] = info.value("shard", "");
+            string hash = info.value("hash", "");
+            try {
+                size_t used = 0;
+                generation.hashes[name] = stoull(hash, &used, 16);
+                if (used != hash.size()) throw invalid_argument(hash);
+            } catch (const exception&) {
+                generation.hashes[name] = bodyHash(readBody(name));  // Missing or malformed: hash the old body
+            }
+        }
+        return generation;
+    }
+    
+    /**
+     * RFC 6902 patch from the previous generation to config. Instruments whose body hash is unchanged
+     * are skipped without being compared; changed ones get a structural json::diff under their
+     * pointer, added and removed ones a single add/remove. Every replace and remove is preceded by a
+     * "test" of the value it overwrites, so applying the patch to any other generation fails as a
+     * whole instead of silently mixing generations.
+     */
+    static json diffGenerations(const json& config, const Generation& previous, size_t& changed, size_t& skipped) {
+        json patch = json::array();
+        for (const auto& [name, hash] : previous.hashes) {
+            if (!config.contains(name)) {
+                string path = "/" + pointerToken(name);
+                patch.push_back({{"op", "test"}, {"path", path}, {"value", previous.body(name)}});
+                patch.push_back({{"op", "remove"}, {"path", path}});
+                ++changed;
+            }
+        }
+        for (const auto& [name, body] : config.items()) {
+            string path = "/" + pointerToken(name);
+            auto it = previous.hashes.find(name);
+            if (it == previous.hashes.end()) {
+                patch.push_back({{"op", "add"}, {"path", path}, {"value", body}});
+                ++changed;
+            } else if (it->second == bodyHash(body)) {
+                ++skipped;
+            } else {
+                json base = previous.body(name);
+                for (auto& op : json::diff(base, body)) {
+                    string pointer = op["path"].get<string>();
+                    op["path"] = path + pointer;
+                    if (op["op"] != "add") {
+                        patch.push_back({{"op", "test"}, {"path", op["path"]}, {"value", base.at(json::json_pointer(pointer))}});
+                    }
+                    patch.push_back(std::move(op));
+                }
+                ++changed;
+            }
+        }
+        return patch;
+    }
+    
+    void writePatch(const json& config, const optional<Generation>& previous, const string& outputPath) {
+        if (!previous) {
+            cout << "No previous generation at " << outputPath << "; patch not written" << endl;
+            return;
+        }
+        size_t changed = 0, skipped = 0;
+        json patch = diffGenerations(config, *previous, changed, skipped);
+        
+        string patchPath = patchPathFor(outputPath);
+        ofstream patchFile(patchPath, ios::binary);
+        if (!patchFile) {
+            cerr << "Error: Cannot create patch file " << patchPath << endl;
+            return;
+        }
+        if (*patchFormat == PatchFormat::Cbor) {
+            vector<uint8_t> bytes = json::to_cbor(patch);
+            patchFile.write((const char*)bytes.data(), bytes.size());
+        } else {
+            patchFile << patch.dump(2);
+        }
+        cout << "Patch saved to " << patchPath << ": " << patch.size() << " operation(s) for " << changed
+             << " changed instrument(s), " << skipped << " unchanged skipped" << endl;
+    }
+    
+    // Shard file for an instrument: its sanitized name, or "bucket_<n>.json" when hashing into buckets
+    static string shardFileName(const string& name, size_t bucketCount, set<string>& usedNames) {
+        uint32_t hash = 2166136261u;  // FNV-1a
+        for (unsigned char c : name) {
+            hash = (hash ^ c) * 16777619u;
+        }
+        char suffix[16];
+        if (bucketCount > 0) {
+            snprintf(suffix, sizeof(suffix), "%04zu", (size_t)(hash % bucketCount));
+            return string("bucket_") + suffix + ".json";
+        }
+        
+        string file = name;
+        for (char& c : file) {
+            if (!isalnum((unsigned char)c) && c != '_' && c != '-') c = '_';
+        }
+        string lowered = file;
+        transform(lowered.begin(), lowered.end(), lowered.begin(), ::tolower);
+        if (!usedNames.insert(lowered).second) {
+            snprintf(suffix, sizeof(suffix), "_%08x", hash);  // Two names sanitize to the same file
+            file += suffix;
+        }
+        return file + ".json";
+    }
+    
+    // Manifest header: top-level fields with nested bodies nulled, except the small soundCharacteristics
+    static json shardHeader(const json& body) {
+        json header = json::object();
+        for (const auto& [key, value] : body.items()) {
+            bool nested = value.is_object() || value.is_array();
+            header[key] = (nested && key != "soundCharacteristics") ? json(nullptr) : value;
+        }
+        return header;
+    }
+    
     // Create structure mapping JSON from SectionMapping
     json createStructureMapping(const SectionMapping& mapping) {
         json structure = json::object();
@@ -384,10 +614,18 @@ public:
         return finalConfig;
     }
     
+    // Also write <output>.patch.json / .patch.cbor against the generation being replaced
+    void setPatchOutput(PatchFormat format) {
+        patchFormat = format;
+    }
+    
     // Save configuration to file
     bool saveConfig(const string& filename) {
         try {
             json config = generateCleanConfig();
+            if (patchFormat) {
+                writePatch(config, previousMonolithic(filename), filename);
+            }
             
             ofstream outFile(filename);
             if (!outFile) {
@@ -408,6 +646,101 @@ public:
         }
     }
     
+    // Write a whole file, reporting a failed open or write (the caller renames it into place)
+    static bool writeFile(const filesystem::path& path, const string& contents) {
+        ofstream file(path, ios::binary);
+        if (!file) {
+            cerr << "Error: Cannot create output file " << path.string() << endl;
+            return false;
+        }
+        file << contents;
+        file.close();
+        if (!file) {
+            cerr << "Error: Failed writing " << path.string() << endl;
+            return false;
+        }
+        return true;
+    }
+    
+    static void removeAll(const vector<filesystem::path>& paths) {
+        for (const auto& path : paths) {
+            error_code ignored;
+            filesystem::remove(path, ignored);
+        }
+    }
+    
+    /**
+     * Sharded output: one shard file per instrument (bucketCount == 0) or per FNV-1a hash bucket of
+     * the instrument name, plus a manifest mapping every instrument to its shard. Each manifest entry
+     * carries a header (scalar fields and soundCharacteristics) so consumers can index instruments
+     * before fetching their bodies. shardDir is relative to the manifest's directory. Readers of the old
+     * manifest never see a partly written file, and shard files left over from it are removed.
+     */
+    bool saveShardedConfig(const string& manifestPath, const string& shardDir, size_t bucketCount = 0) {
+        try {
+            json config = generateCleanConfig();
+            if (patchFormat) {
+                writePatch(config, previousSharded(manifestPath), manifestPath);  // Before old shards are overwritten
+            }
+            filesystem::path shardRoot = filesystem::path(manifestPath).parent_path() / shardDir;
+            filesystem::create_directories(shardRoot);
+            
+            map<string, json> shards;  // Shard file -> {instrument: body}
+            set<string> usedNames;     // Lowercased per-instrument file names, for case-insensitive filesystems
+            json instruments = json::object();
+            for (auto& [name, body] : config.items()) {
+                string shard = shardFileName(name, bucketCount, usedNames);
+                instruments[name] = {{"shard", shard}, {"hash", hashHex(bodyHash(body))}, {"header", shardHeader(body)}};
+                shards[shard][name] = std::move(body);
+            }
+            
+            // Every file goes to a temp file first; shards are renamed into place, then the manifest last
+            vector<filesystem::path> written;
+            for (const auto& [shard, bodies] : shards) {
+                written.push_back(shardRoot / (shard + ".tmp"));
+                if (!writeFile(written.back(), bodies.dump(2))) {
+                    removeAll(written);
+                    return false;
+                }
+            }
+            json manifest = {
+                {"format", "clean_config_shards"},
+                {"version", 1},
+                {"shardDir", shardDir},
+                {"instruments", std::move(instruments)}
+            };
+            filesystem::path manifestTemp = manifestPath + ".tmp";
+            written.push_back(manifestTemp);
+            if (!writeFile(manifestTemp, manifest.dump(2))) {
+                removeAll(written);
+                return false;
+            }
+            for (const auto& [shard, bodies] : shards) {
+                filesystem::rename(shardRoot / (shard + ".tmp"), shardRoot / shard);
+            }
+            filesystem::rename(manifestTemp, manifestPath);
+            
+            // Shards of the replaced generation the new manifest no longer references (e.g. fewer buckets)
+            size_t removed = 0;
+            for (const auto& entry : filesystem::directory_iterator(shardRoot)) {
+                if (entry.is_regular_file() && entry.path().extension() == ".json" &&
+                    !shards.count(entry.path().filename().string())) {
+                    removed += filesystem::remove(entry.path());
+                }
+            }
+            
+            cout << "Sharded configuration saved to " << manifestPath << " (" << shards.size()
+                 << " shard files in " << shardRoot.string() << ")" << endl;
+            if (removed > 0) cout << "Removed " << removed << " stale shard file(s)" << endl;
+            cout << "Total instruments/groups processed: " << config.size() << endl;
+            
+            return true;
+        } catch (const exception& e) {
+            cerr << "Error saving sharded configuration: " << e.what() << endl;
+            return false;
+        }
+    }
+    
     // Print summary of what was processed
     void printSummary() {
         cout << "\n=== JSON Reader System Summary ===" << endl;
@@ -428,11 +761,41 @@ public:
     }
 };
 
-int main() {
+// --sharded [buckets] writes clean_config.manifest.json and clean_config_shards/ instead of one file
+// --patch [json|cbor] also writes clean_config.patch.json/.cbor, the delta from the generation being replaced
+int main(int argc, char* argv[]) {
     cout << "JSON Reader System - Clean Configuration Generator" << endl;
     cout << "=================================================" << endl;
     
     JsonReaderSystem system;
+    bool sharded = false;
+    size_t bucketCount = 0;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--sharded") {
+            sharded = true;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) {
+                const char* text = argv[++i];
+                const char* end = text + strlen(text);
+                auto [ptr, ec] = from_chars(text, end, bucketCount);
+                if (ec != errc() || ptr != end) {
+                    cerr << "Usage: --sharded [buckets] expects a non-negative integer, got '" << text << "'" << endl;
+                    return 1;
+                }
+            }
+        } else if (arg == "--patch") {
+            PatchFormat format = PatchFormat::Json;
+            if (i + 1 < argc && string(argv[i + 1]) == "cbor") {
+                format = PatchFormat::Cbor;
+                ++i;
+            } else if (i + 1 < argc && string(argv[i + 1]) == "json") {
+                ++i;
+            }
+            system.setPatchOutput(format);
+        } else {
+            cerr << "Ignoring unknown argument: " << arg << endl;
+        }
+    }
     
     // Load all JSON files
     if (!system.loadJsonFiles()) {
@@ -441,7 +804,9 @@ int main() {
     }
     
     // Generate and save clean configuration
-    if (!system.saveConfig("clean_config.json")) {
+    bool saved = sharded ? system.saveShardedConfig("clean_config.manifest.json", "clean_config_shards", bucketCount)
+                         : system.saveConfig("clean_config.json");
+    if (!saved) {
         cerr << "Failed to save configuration. Exiting." << endl;
         return 1;
     }
@@ -1,4 +1,5 @@
 #include "json.hpp"
+#include "pointing_shared.hpp"
 #include <iostream>
 #include <fstream>
 #include <map>
@@ -13,6 +14,16 @@
 #include <chrono>
 #include <sstream>
 #include <memory>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <filesystem>
+#include <limits>
+#include <queue>
+#include <random>
+#include <numeric>
+#include <iomanip>
+#include <mutex>
 
 using namespace std;
 using json = nlohmann::json;
@@ -30,7 +41,7 @@ struct EnhancedConfigEntry {
     string id;
     string name;
     string category;  // guitar, group, effect
-    json configData;  // Original configuration data
+    SharedConfigData configData;  // Original configuration data, fields shared across entries
     
     // 1D: Semantic metadata (existing)
     vector<string> semanticTags;
@@ -96,8 +107,156 @@ struct EnhancedConfigEntry {
         int latencyMs = 0;
         string cpuUsage = "low";           // low, medium, high
     } pluginInfo;
+    
+    // Persisted form of the enriched entry (see MultiDimensionalPointingSystem::saveEnrichedCache);
+    // sharded sources leave configData out and fetch it from the shard when needed
+    json toCacheJson(bool includeConfigData = true) const {
+        json j;
+        j["id"] = id;
+        j["name"] = name;
+        j["category"] = category;
+        if (includeConfigData) j["configData"] = configData.materialize();
+        j["semanticTags"] = semanticTags;
+        j["description"] = description;
+        j["embedding"] = embedding;
+        j["techSpecs"] = {
+            {"sampleRate", techSpecs.sampleRate}, {"bitDepth", techSpecs.bitDepth},
+            {"polyphonyLimit", techSpecs.polyphonyLimit}, {"envelopeType", techSpecs.envelopeType},
+            {"supportedFormats", techSpecs.supportedFormats}, {"minBPM", techSpecs.minBPM},
+            {"maxBPM", techSpecs.maxBPM}, {"supportsRealtime", techSpecs.supportsRealtime},
+            {"midiChannelSupport", techSpecs.midiChannelSupport}, {"bufferSizeMin", techSpecs.bufferSizeMin},
+            {"bufferSizeMax", techSpecs.bufferSizeMax}, {"requiredEffects", techSpecs.requiredEffects},
+            {"incompatibleEffects", techSpecs.incompatibleEffects}
+        };
+        j["musicalRole"] = {
+            {"primaryRole", musicalRole.primaryRole}, {"secondaryRoles", musicalRole.secondaryRoles},
+            {"musicalContext", musicalRole.musicalContext}, {"prominence", musicalRole.prominence},
+            {"isRhythmic", musicalRole.isRhythmic}, {"isMelodic", musicalRole.isMelodic},
+            {"isHarmonic", musicalRole.isHarmonic}, {"typicalPartners", musicalRole.typicalPartners},
+            {"dynamicRange", musicalRole.dynamicRange}, {"tonalCharacter", musicalRole.tonalCharacter}
+        };
+        j["layeringInfo"] = {
+            {"preferredLayer", layeringInfo.preferredLayer}, {"compatibleLayers", layeringInfo.compatibleLayers},
+            {"arrangementPosition", layeringInfo.arrangementPosition}, {"stereoWidth", layeringInfo.stereoWidth},
+            {"frequencyRange", layeringInfo.frequencyRange}, {"canDoubleOctave", layeringInfo.canDoubleOctave},
+            {"maxSimultaneousInstances", layeringInfo.maxSimultaneousInstances}, {"mixPriority", layeringInfo.mixPriority}
+        };
+        j["compatibleWith"] = compatibleWith;
+        j["incompatibleWith"] = incompatibleWith;
+        j["preferredCombinations"] = preferredCombinations;
+        j["pluginInfo"] = {
+            {"pluginFormat", pluginInfo.pluginFormat}, {"vendor", pluginInfo.vendor},
+            {"version", pluginInfo.version}, {"hostCompatibility", pluginInfo.hostCompatibility},
+            {"supportsAutomation", pluginInfo.supportsAutomation}, {"supportsMPE", pluginInfo.supportsMPE},
+            {"latencyMs", pluginInfo.latencyMs}, {"cpuUsage", pluginInfo.cpuUsage}
+        };
+        return j;
+    }
+    
+    void fromCacheJson(const json& j, JsonInternPool& pool) {
+        id = j.value("id", "");
+        name = j.value("name", "");
+        category = j.value("category", "");
+        if (j.contains("configData")) configData = SharedConfigData::fromJson(j["configData"], pool);
+        semanticTags = j.value("semanticTags", vector<string>{});
+        description = j.value("description", "");
+        embedding = j.value("embedding", vector<float>{});
+        
+        const json& t = j.contains("techSpecs") ? j["techSpecs"] : json::object();
+        techSpecs.sampleRate = t.value("sampleRate", techSpecs.sampleRate);
+        techSpecs.bitDepth = t.value("bitDepth", techSpecs.bitDepth);
+        techSpecs.polyphonyLimit = t.value("polyphonyLimit", techSpecs.polyphonyLimit);
+        techSpecs.envelopeType = t.value("envelopeType", techSpecs.envelopeType);
+        techSpecs.supportedFormats = t.value("supportedFormats", techSpecs.supportedFormats);
+        techSpecs.minBPM = t.value("minBPM", techSpecs.minBPM);
+        techSpecs.maxBPM = t.value("maxBPM", techSpecs.maxBPM);
+        techSpecs.supportsRealtime = t.value("supportsRealtime", techSpecs.supportsRealtime);
+        techSpecs.midiChannelSupport = t.value("midiChannelSupport", techSpecs.midiChannelSupport);
+        techSpecs.bufferSizeMin = t.value("bufferSizeMin", techSpecs.bufferSizeMin);
+        techSpecs.bufferSizeMax = t.value("bufferSizeMax", techSpecs.bufferSizeMax);
+        techSpecs.requiredEffects = t.value("requiredEffects", techSpecs.requiredEffects);
+        techSpecs.incompatibleEffects = t.value("incompatibleEffects", techSpecs.incompatibleEffects);
+        
+        const json& r = j.contains("musicalRole") ? j["musicalRole"] : json::object();
+        musicalRole.primaryRole = r.value("primaryRole", musicalRole.primaryRole);
+        musicalRole.secondaryRoles = r.value("secondaryRoles", musicalRole.secondaryRoles);
+        musicalRole.musicalContext = r.value("musicalContext", musicalRole.musicalContext);
+        musicalRole.prominence = r.value("prominence", musicalRole.prominence);
+        musicalRole.isRhythmic = r.value("isRhythmic", musicalRole.isRhythmic);
+        musicalRole.isMelodic = r.value("isMelodic", musicalRole.isMelodic);
+        musicalRole.isHarmonic = r.value("isHarmonic", musicalRole.isHarmonic);
+        musicalRole.typicalPartners = r.value("typicalPartners", musicalRole.typicalPartners);
+        musicalRole.dynamicRange = r.value("dynamicRange", musicalRole.dynamicRange);
+        musicalRole.tonalCharacter = r.value("tonalCharacter", musicalRole.tonalCharacter);
+        
+        const json& l = j.contains("layeringInfo") ? j["layeringInfo"] : json::object();
+        layeringInfo.preferredLayer = l.value("preferredLayer", layeringInfo.preferredLayer);
+        layeringInfo.compatibleLayers = l.value("compatibleLayers", layeringInfo.compatibleLayers);
+        layeringInfo.arrangementPosition = l.value("arrangementPosition", layeringInfo.arrangementPosition);
+        layeringInfo.stereoWidth = l.value("stereoWidth", layeringInfo.stereoWidth);
+        layeringInfo.frequencyRange = l.value("frequencyRange", layeringInfo.frequencyRange);
+        layeringInfo.canDoubleOctave = l.value("canDoubleOctave", layeringInfo.canDoubleOctave);
+        layeringInfo.maxSimultaneousInstances = l.value("maxSimultaneousInstances", layeringInfo.maxSimultaneousInstances);
+        layeringInfo.mixPriority = l.value("mixPriority", layeringInfo.mixPriority);
+        
+        compatibleWith = j.value("compatibleWith", vector<string>{});
+        incompatibleWith = j.value("incompatibleWith", vector<string>{});
+        preferredCombinations = j.value("preferredCombinations", vector<string>{});
+        
+        const json& p = j.contains("pluginInfo") ? j["pluginInfo"] : json::object();
+        pluginInfo.pluginFormat = p.value("pluginFormat", pluginInfo.pluginFormat);
+        pluginInfo.vendor = p.value("vendor", pluginInfo.vendor);
+        pluginInfo.version = p.value("version", pluginInfo.version);
+        pluginInfo.hostCompatibility = p.value("hostCompatibility", pluginInfo.hostCompatibility);
+        pluginInfo.supportsAutomation = p.value("supportsAutomation", pluginInfo.supportsAutomation);
+        pluginInfo.supportsMPE = p.value("supportsMPE", pluginInfo.supportsMPE);
+        pluginInfo.latencyMs = p.value("latencyMs", pluginInfo.latencyMs);
+        pluginInfo.cpuUsage = p.value("cpuUsage", pluginInfo.cpuUsage);
+    }
 };
 
+// Run body(i) for i in [0, count) across worker threads (0 = hardware concurrency).
+// Indices are handed out in small chunks from a shared counter, so uneven work balances out.
+void parallelFor(size_t count, unsigned threads, const function<void(size_t)>& body) {
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    threads = (unsigned)min<size_t>(threads, max<size_t>(count, 1));
+    
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; ++i) body(i);
+        return;
+    }
+    
+    const size_t chunk = max<size_t>(1, count / (threads * 8));
+    atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t begin = next.fetch_add(chunk); begin < count; begin = next.fetch_add(chunk)) {
+            size_t end = min(count, begin + chunk);
+            for (size_t i = begin; i < end; ++i) body(i);
+        }
+    };
+    
+    vector<thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool) th.join();
+}
+
+// Split [0, count) into contiguous blocks and run body(block, begin, end) for each across worker
+// threads. Callers keep one accumulator per block and merge them in block order, which keeps
+// reductions deterministic regardless of the thread count.
+size_t parallelBlockCount(size_t count, unsigned threads) {
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    return min<size_t>(count, (size_t)threads * 4);
+}
+
+void parallelForBlocks(size_t count, unsigned threads, const function<void(size_t, size_t, size_t)>& body) {
+    const size_t blocks = parallelBlockCount(count, threads);
+    parallelFor(blocks, threads, [&](size_t block) {
+        body(block, block * count / blocks, (block + 1) * count / blocks);
+    });
+}
+
 // 1D: Semantic Pointing System (Enhanced from existing)
 class SemanticPointer {
 private:
@@ -351,13 +510,18 @@ public:
     
     RoleCompatibilityMatrix matrix;
     
+    // Read-only lookup (no operator[] insertion) so scoring is safe to run from several threads
+    bool rolesCompatible(const string& roleA, const string& roleB) const {
+        auto it = matrix.compatibleRoles.find(roleA);
+        return it != matrix.compatibleRoles.end() &&
+               find(it->second.begin(), it->second.end(), roleB) != it->second.end();
+    }
+    
     float calculateMusicalRoleCompatibility(const EnhancedConfigEntry& a, const EnhancedConfigEntry& b) {
         float score = 0.0f;
         
         // Check role compatibility
-        auto& compatibleRoles = matrix.compatibleRoles[a.musicalRole.primaryRole];
-        bool roleCompatible = find(compatibleRoles.begin(), compatibleRoles.end(), 
-                                 b.musicalRole.primaryRole) != compatibleRoles.end();
+        bool roleCompatible = rolesCompatible(a.musicalRole.primaryRole, b.musicalRole.primaryRole);
         
         if (roleCompatible) {
             score += 0.4f;
@@ -395,9 +559,7 @@ public:
     vector<string> explainMusicalRoleMatch(const EnhancedConfigEntry& a, const EnhancedConfigEntry& b) {
         vector<string> explanations;
         
-        auto& compatibleRoles = matrix.compatibleRoles[a.musicalRole.primaryRole];
-        bool roleCompatible = find(compatibleRoles.begin(), compatibleRoles.end(), 
-                                 b.musicalRole.primaryRole) != compatibleRoles.end();
+        bool roleCompatible = rolesCompatible(a.musicalRole.primaryRole, b.musicalRole.primaryRole);
         
         if (roleCompatible) {
             explanations.push_back("Compatible musical roles: " + a.musicalRole.primaryRole + 
@@ -466,13 +628,18 @@ public:
     
     LayeringRules rules;
     
+    // Read-only lookup (no operator[] insertion) so scoring is safe to run from several threads
+    bool layersCompatible(const string& layerA, const string& layerB) const {
+        auto it = rules.layerCompatibility.find(layerA);
+        return it != rules.layerCompatibility.end() &&
+               find(it->second.begin(), it->second.end(), layerB) != it->second.end();
+    }
+    
     float calculateLayeringCompatibility(const EnhancedConfigEntry& a, const EnhancedConfigEntry& b) {
         float score = 0.0f;
         
         // Check layer compatibility
-        auto& compatibleLayers = rules.layerCompatibility[a.layeringInfo.preferredLayer];
-        if (find(compatibleLayers.begin(), compatibleLayers.end(), 
-                b.layeringInfo.preferredLayer) != compatibleLayers.end()) {
+        if (layersCompatible(a.layeringInfo.preferredLayer, b.layeringInfo.preferredLayer)) {
             score += 0.3f;
         }
         
@@ -507,9 +674,7 @@ public:
     vector<string> explainLayeringMatch(const EnhancedConfigEntry& a, const EnhancedConfigEntry& b) {
         vector<string> explanations;
         
-        auto& compatibleLayers = rules.layerCompatibility[a.layeringInfo.preferredLayer];
-        if (find(compatibleLayers.begin(), compatibleLayers.end(), 
-                b.layeringInfo.preferredLayer) != compatibleLayers.end()) {
+        if (layersCompatible(a.layeringInfo.preferredLayer, b.layeringInfo.preferredLayer)) {
             explanations.push_back("Compatible layers: " + a.layeringInfo.preferredLayer + 
                                  " with " + b.layeringInfo.preferredLayer);
         }
@@ -578,38 +743,266 @@ private:
     LayeringArrangementPointer layeringPointer;
     
     vector<EnhancedConfigEntry> configDatabase;
+    unordered_map<string, size_t> idIndex;  // id -> first configDatabase index with that id
+    
+    // Coarse k-means partition of configDatabase used to prune compatibility queries.
+    // Each cluster keeps the value sets its members span, from which an upper bound
+    // on analyzeCompatibility(anchor, member).overallScore is derived per query.
+    struct ConfigCluster {
+        vector<float> centroid;            // Over the combined feature vector (clusterFeatures)
+        vector<size_t> members;            // Indices into configDatabase
+        vector<float> embeddingCentroid;   // Mean of members' unit embeddings
+        float embeddingRadius = 0.0f;      // Max distance of a member unit embedding from embeddingCentroid
+        set<string> roles, contexts, tonalCharacters, layers, frequencyRanges, arrangementPositions;
+        unordered_map<string, int> maxTagCount;  // Tag -> highest multiplicity on any one member
+        float minProminence = 1.0f, maxProminence = 0.0f;
+        float minMixPriority = 1.0f, maxMixPriority = 0.0f;
+        float minStereoWidth = 1.0f;
+    };
+    
+    vector<ConfigCluster> clusters;
+    vector<uint32_t> clusterAssignments;   // configDatabase index -> cluster index
+    
+    // Set when loaded from a shard manifest: configData stays empty until an entry is exported
+    optional<CleanConfigShards> shards;
+    
+    JsonInternPool configPool;  // Hash-consed configData field values
     
 public:
     MultiDimensionalPointingSystem() {
         loadConfigDatabase();
     }
     
-    void loadConfigDatabase() {
-        // Load and enhance existing configuration data
-        ifstream configFile("clean_config.json");
-        if (!configFile) {
-            cerr << "Could not load clean_config.json" << endl;
+    // Start empty (e.g. to enrich a generated database); loadConfigDatabase() can be called later
+    explicit MultiDimensionalPointingSystem(bool loadDefaultDatabase) {
+        if (loadDefaultDatabase) loadConfigDatabase();
+    }
+    
+    // Worker threads used for enrichment (0 = hardware concurrency)
+    unsigned workerThreads = 0;
+    // Enriched database persisted next to clean_config.json; reused while the source is unchanged
+    string enrichedCachePath = "enhanced_config_cache.json";
+    static constexpr int ENRICHED_CACHE_FORMAT = 2;
+    
+    // sourcePath may also be a *.manifest.json from json_reader_system --sharded
+    void loadConfigDatabase(const string& sourcePath = "clean_config.json") {
+        configDatabase.clear();
+        idIndex.clear();
+        shards.reset();
+        configPool.clear();
+        
+        if (CleanConfigShards::isManifestPath(sourcePath)) {
+            ifstream manifestFile(sourcePath);
+            if (!manifestFile) {
+                cerr << "Could not load " << sourcePath << endl;
+                return;
+            }
+            json manifest;
+            manifestFile >> manifest;
+            shards.emplace(manifest, sourcePath);
+        }
+        
+        json sourceSignature = fileSignature(sourcePath);
+        if (!sourceSignature.is_null() && loadEnrichedCache(sourceSignature)) {
+            cout << "Loaded " << configDatabase.size() << " configurations with multi-dimensional metadata (from "
+                 << enrichedCachePath << ")." << endl;
+            if (clusters.empty()) buildClusters();
             return;
         }
         
+        // Load and enhance existing configuration data; enrichment reads every body, shards included
         json cleanConfig;
-        configFile >> cleanConfig;
+        if (shards) {
+            cleanConfig = json::object();
+            for (const auto& [name, _] : shards->headers.items()) {
+                cleanConfig[name] = shards->fetch(name);
+            }
+        } else {
+            ifstream configFile(sourcePath);
+            if (!configFile) {
+                cerr << "Could not load " << sourcePath << endl;
+                return;
+            }
+            configFile >> cleanConfig;
+        }
+        
+        enrichConfigs(std::move(cleanConfig));
+        buildClusters();
         
-        // Convert to enhanced entries with metadata
-        for (const auto& [name, config] : cleanConfig.items()) {
-            EnhancedConfigEntry entry = createEnhancedEntry(name, config);
-            configDatabase.push_back(entry);
+        cout << "Loaded " << configDatabase.size() << " configurations with multi-dimensional metadata ("
+             << clusters.size() << " clusters)." << endl;
+        
+        if (!sourceSignature.is_null()) {
+            saveEnrichedCache(sourceSignature);
         }
+    }
+    
+    /**
+     * Apply a clean_config patch (json_reader_system --patch) in place of a reload: only touched
+     * configs are patched and re-enriched (added ones appended, removed ones dropped), then the id
+     * index and clusters are rebuilt. Returns false and changes nothing when the patch does not apply.
+     */
+    bool applyConfigPatch(const string& patchPath) {
+        json patch = readConfigPatch(patchPath);
+        if (!patch.is_array()) return false;
+        optional<set<string>> touched = patchedInstruments(patch);
+        if (!touched) {
+            cerr << "Patch " << patchPath << " replaces the whole config; reload it instead" << endl;
+            return false;
+        }
+        
+        // Patch a copy first; bodies fetched from shards go back to them if the patch does not apply
+        json subset = json::object();
+        vector<string> fetched;
+        for (const string& name : *touched) {
+            if (optional<size_t> index = findIndexById(name)) {
+                const EnhancedConfigEntry& entry = configDatabase[*index];
+                if (shards && entry.configData.empty()) {
+                    subset[name] = shards->fetch(name);
+                    fetched.push_back(name);
+                } else {
+                    subset[name] = entry.configData.materialize();
+                }
+            }
+        }
+        try {
+            subset = subset.patch(patch);
+        } catch (const exception& e) {
+            cerr << "Patch " << patchPath << " does not apply to the loaded database: " << e.what() << endl;
+            for (const string& name : fetched) shards->restore(name, std::move(subset[name]));
+            return false;
+        }
+        
+        size_t reenriched = 0;
+        for (const string& name : *touched) {
+            optional<size_t> index = findIndexById(name);
+            if (!subset.contains(name)) {
+                if (index) configDatabase.erase(configDatabase.begin() + *index);
+                rebuildIdIndex();
+                continue;
+            }
+            EnhancedConfigEntry entry;
+            populateEnhancedEntry(entry, name, std::move(subset[name]));
+            if (index) {
+                configDatabase[*index] = std::move(entry);
+            } else {
+                configDatabase.push_back(std::move(entry));
+                rebuildIdIndex();
+            }
+            ++reenriched;
+        }
+        buildClusters();
         
-        cout << "Loaded " << configDatabase.size() << " configurations with multi-dimensional metadata." << endl;
+        cout << "Applied patch " << patchPath << ": " << patch.size() << " operation(s), " << reenriched
+             << " configuration(s) re-enriched, " << configDatabase.size() << " total" << endl;
+        return true;
+    }
+    
+    // Enrich every clean_config item into configDatabase, in source order, across workerThreads.
+    // Each config is moved out of cleanConfig into its entry rather than deep-copied.
+    void enrichConfigs(json cleanConfig) {
+        vector<pair<const string*, json*>> items;
+        items.reserve(cleanConfig.size());
+        for (auto it = cleanConfig.begin(); it != cleanConfig.end(); ++it) {
+            items.emplace_back(&it.key(), &it.value());
+        }
+        
+        // Entries are constructed in place at their final index, so ordering is stable
+        configDatabase.resize(items.size());
+        parallelFor(items.size(), workerThreads, [&](size_t i) {
+            populateEnhancedEntry(configDatabase[i], *items[i].first, std::move(*items[i].second));
+        });
+        rebuildIdIndex();
     }
     
 private:
-    EnhancedConfigEntry createEnhancedEntry(const string& name, const json& config) {
-        EnhancedConfigEntry entry;
+    // Size + modification time identify a clean_config generation without hashing its contents
+    static json fileSignature(const string& path) {
+        error_code ec;
+        auto size = filesystem::file_size(path, ec);
+        if (ec) return nullptr;
+        auto mtime = filesystem::last_write_time(path, ec);
+        if (ec) return nullptr;
+        return {
+            {"path", path},
+            {"size", size},
+            {"mtime", (long long)mtime.time_since_epoch().count()}
+        };
+    }
+    
+    bool loadEnrichedCache(const json& sourceSignature) {
+        ifstream cacheFile(enrichedCachePath);
+        if (!cacheFile) return false;
+        
+        json cache;
+        try {
+            cacheFile >> cache;
+        } catch (const exception& e) {
+            cerr << "Ignoring unreadable " << enrichedCachePath << ": " << e.what() << endl;
+            return false;
+        }
+        
+        if (cache.value("format", 0) != ENRICHED_CACHE_FORMAT || !cache.contains("source") ||
+            cache["source"] != sourceSignature || !cache.contains("entries") || !cache["entries"].is_array()) {
+            return false;  // Stale or foreign cache: re-derive
+        }
+        
+        const json& entries = cache["entries"];
+        configDatabase.resize(entries.size());
+        parallelFor(entries.size(), workerThreads, [&](size_t i) {
+            configDatabase[i].fromCacheJson(entries[i], configPool);
+        });
+        rebuildIdIndex();
+        
+        if (cache.contains("clusters") && cache["clusters"].is_object()) {
+            restoreClusters(cache["clusters"]);
+        }
+        return true;
+    }
+    
+    void saveEnrichedCache(const json& sourceSignature) {
+        json entries = json::array();
+        for (const auto& entry : configDatabase) {
+            entries.push_back(entry.toCacheJson(!shards));
+        }
+        
+        json cache = {
+            {"format", ENRICHED_CACHE_FORMAT},
+            {"source", sourceSignature},
+            {"entries", std::move(entries)},
+            {"clusters", {
+                {"centroids", clusterCentroids()},
+                {"assignments", clusterAssignments}
+            }}
+        };
+        
+        ofstream cacheFile(enrichedCachePath);
+        if (!cacheFile) {
+            cerr << "Could not write " << enrichedCachePath << endl;
+            return;
+        }
+        cacheFile << cache.dump();
+    }
+    
+    // Fetch an entry's configData from its shard if it was loaded without it
+    void ensureConfigData(EnhancedConfigEntry& entry) {
+        if (shards && entry.configData.empty()) {
+            entry.configData = SharedConfigData::fromJson(shards->fetch(entry.id), configPool);
+        }
+    }
+    
+    void rebuildIdIndex() {
+        idIndex.clear();
+        idIndex.reserve(configDatabase.size());
+        for (size_t i = 0; i < configDatabase.size(); ++i) {
+            idIndex.emplace(configDatabase[i].id, i);
+        }
+    }
+    
+    void populateEnhancedEntry(EnhancedConfigEntry& entry, const string& name, json&& source) {
         entry.id = name;
         entry.name = name;
-        entry.configData = config;
+        const json& config = source;
         
         // Determine category
         if (config.contains("guitarParams")) {
@@ -635,7 +1028,7 @@ private:
         // Set compatibility information
         setCompatibilityInfo(entry, config);
         
-        return entry;
+        entry.configData = SharedConfigData::fromJson(std::move(source), configPool);
     }
     
     void extractSemanticMetadata(EnhancedConfigEntry& entry, const json& config) {
@@ -909,47 +1302,484 @@ public:
     }
     
     /**
-     * Find compatible configurations for a given anchor
+     * Find compatible configurations for a given anchor.
+     * diversity in [0, 1] re-ranks with maximal marginal relevance so near-duplicate
+     * candidates (same tags, same embedding) do not crowd the top results; 0 keeps pure score order.
      */
     vector<pair<EnhancedConfigEntry, MultiDimensionalResult>> findCompatibleConfigurations(
-        const string& anchorId, int maxResults = 10) {
-        
-        vector<pair<EnhancedConfigEntry, MultiDimensionalResult>> results;
+        const string& anchorId, int maxResults = 10, float diversity = 0.0f) {
         
         // Find anchor configuration
-        auto anchorIt = find_if(configDatabase.begin(), configDatabase.end(),
-                               [&](const EnhancedConfigEntry& entry) { return entry.id == anchorId; });
-        
-        if (anchorIt == configDatabase.end()) {
-            return results;
+        optional<size_t> anchorIndex = findIndexById(anchorId);
+        if (!anchorIndex) {
+            return {};
         }
         
-        const EnhancedConfigEntry& anchor = *anchorIt;
+        const EnhancedConfigEntry& anchor = configDatabase[*anchorIndex];
         
-        // Analyze compatibility with all other configurations
-        for (const auto& candidate : configDatabase) {
-            if (candidate.id == anchorId) continue;
-            
-            MultiDimensionalResult compatibility = analyzeCompatibility(anchor, candidate);
-            if (compatibility.overallScore >= 0.5f) {  // Minimum threshold
-                results.emplace_back(candidate, compatibility);
+        // Analyze compatibility with all other configurations; each block keeps its own hits
+        // and the blocks are concatenated in database order
+        vector<vector<pair<size_t, MultiDimensionalResult>>> blockHits(
+            parallelBlockCount(configDatabase.size(), workerThreads));
+        parallelForBlocks(configDatabase.size(), workerThreads, [&](size_t block, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                if (configDatabase[i].id == anchorId) continue;
+                
+                MultiDimensionalResult compatibility = analyzeCompatibility(anchor, configDatabase[i]);
+                if (compatibility.overallScore >= 0.5f) {  // Minimum threshold
+                    blockHits[block].emplace_back(i, std::move(compatibility));
+                }
             }
+        });
+        
+        vector<pair<size_t, MultiDimensionalResult>> ranked;
+        for (auto& hits : blockHits) {
+            move(hits.begin(), hits.end(), back_inserter(ranked));
         }
         
-        // Sort by overall compatibility score
-        sort(results.begin(), results.end(),
+        // Sort by overall compatibility score, breaking ties by database order so equal scores
+        // rank deterministically (and the same way as the cluster-pruned search)
+        sort(ranked.begin(), ranked.end(),
              [](const auto& a, const auto& b) {
-                 return a.second.overallScore > b.second.overallScore;
+                 if (a.second.overallScore != b.second.overallScore) return a.second.overallScore > b.second.overallScore;
+                 return a.first < b.first;
              });
         
+        if (diversity > 0.0f && ranked.size() > (size_t)maxResults) {
+            ranked = diversifyResults(std::move(ranked), maxResults, diversity);
+        }
+        
         // Limit results
-        if (results.size() > maxResults) {
-            results.resize(maxResults);
+        if (ranked.size() > (size_t)maxResults) {
+            ranked.resize(maxResults);
+        }
+        
+        return materializeResults(std::move(ranked));
+    }
+    
+private:
+    vector<pair<size_t, MultiDimensionalResult>> diversifyResults(
+        vector<pair<size_t, MultiDimensionalResult>> ranked, int maxResults, float diversity) {
+        
+        size_t dim = 0;
+        vector<float> relevance;
+        vector<const vector<float>*> embeddings;
+        relevance.reserve(ranked.size());
+        embeddings.reserve(ranked.size());
+        for (const auto& [index, result] : ranked) {
+            relevance.push_back(result.overallScore);
+            embeddings.push_back(&configDatabase[index].embedding);
+            dim = max(dim, configDatabase[index].embedding.size());
+        }
+        
+        vector<float> features = packUnitRows(embeddings, dim);
+        vector<size_t> order = selectMaximalMarginalRelevance(std::move(relevance), features, dim, maxResults, diversity);
+        
+        vector<pair<size_t, MultiDimensionalResult>> diversified;
+        diversified.reserve(order.size());
+        for (size_t index : order) {
+            diversified.push_back(std::move(ranked[index]));
         }
+        return diversified;
+    }
+    
+    // Entries are only copied once the final (truncated) ranking is known
+    vector<pair<EnhancedConfigEntry, MultiDimensionalResult>> materializeResults(
+        vector<pair<size_t, MultiDimensionalResult>> ranked) const {
         
+        vector<pair<EnhancedConfigEntry, MultiDimensionalResult>> results;
+        results.reserve(ranked.size());
+        for (auto& [index, compatibility] : ranked) {
+            results.emplace_back(configDatabase[index], std::move(compatibility));
+        }
         return results;
     }
     
+public:
+    // Work counters for one clustered query
+    struct ClusterSearchStats {
+        size_t clustersTotal = 0;
+        size_t clustersProbed = 0;
+        size_t entriesTotal = 0;
+        size_t entriesScored = 0;
+        
+        float pruningRate() const {
+            return entriesTotal > 0 ? 1.0f - (float)entriesScored / entriesTotal : 0.0f;
+        }
+    };
+    
+    /**
+     * Cluster-pruned compatibility search. Clusters are visited in order of their score
+     * upper bound; a cluster is skipped once its bound cannot beat the 0.5 threshold or
+     * the current k-th best score, so results match findCompatibleConfigurations exactly, order
+ * included: clusters tied with the k-th score are still visited and both paths break score ties
+ * by database order.
+     * maxClusterProbes > 0 additionally caps how many clusters are descended into (approximate).
+     */
+    vector<pair<EnhancedConfigEntry, MultiDimensionalResult>> findCompatibleConfigurationsClustered(
+        const string& anchorId, int maxResults = 10, size_t maxClusterProbes = 0,
+        ClusterSearchStats* stats = nullptr) {
+        
+        optional<size_t> anchorIndex = findIndexById(anchorId);
+        if (!anchorIndex || maxResults <= 0) return {};
+        if (clusters.empty()) buildClusters();
+        
+        const EnhancedConfigEntry& anchor = configDatabase[*anchorIndex];
+        vector<float> anchorEmbedding = unitEmbedding(anchor);
+        
+        vector<pair<float, size_t>> bounds;  // (upper bound, cluster index)
+        bounds.reserve(clusters.size());
+        for (size_t c = 0; c < clusters.size(); ++c) {
+            bounds.emplace_back(clusterScoreBound(anchor, anchorEmbedding, clusters[c]), c);
+        }
+        sort(bounds.begin(), bounds.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+        
+        ClusterSearchStats local;
+        local.clustersTotal = clusters.size();
+        local.entriesTotal = configDatabase.size();
+        
+        // Min-heap of the best overall scores seen so far, capped at maxResults
+        priority_queue<float, vector<float>, greater<float>> topScores;
+        vector<pair<size_t, MultiDimensionalResult>> scored;
+        
+        for (const auto& [bound, c] : bounds) {
+            if (bound < 0.5f) break;  // Below the minimum threshold for every member
+            if ((int)topScores.size() >= maxResults && bound < topScores.top()) break;
+            if (maxClusterProbes > 0 && local.clustersProbed >= maxClusterProbes) break;
+            
+            local.clustersProbed++;
+            for (size_t index : clusters[c].members) {
+                if (index == *anchorIndex) continue;
+                local.entriesScored++;
+                
+                MultiDimensionalResult compatibility = analyzeCompatibility(anchor, configDatabase[index]);
+                if (compatibility.overallScore < 0.5f) continue;  // Minimum threshold
+                
+                topScores.push(compatibility.overallScore);
+                if ((int)topScores.size() > maxResults) topScores.pop();
+                scored.emplace_back(index, std::move(compatibility));
+            }
+        }
+        
+        // Sort by score, breaking ties by database order like the exhaustive scan
+        sort(scored.begin(), scored.end(), [](const auto& a, const auto& b) {
+            if (a.second.overallScore != b.second.overallScore) return a.second.overallScore > b.second.overallScore;
+            return a.first < b.first;
+        });
+        if (scored.size() > (size_t)maxResults) scored.resize(maxResults);
+        
+        if (stats) *stats = local;
+        return materializeResults(std::move(scored));
+    }
+    
+    /**
+     * Partition configDatabase with k-means over clusterFeatures (k = 0 picks sqrt(n)).
+     * The assignment step runs across workerThreads.
+     */
+    void buildClusters(size_t k = 0, int iterations = 12) {
+        clusters.clear();
+        clusterAssignments.assign(configDatabase.size(), 0);
+        const size_t n = configDatabase.size();
+        if (n == 0) return;
+        
+        if (k == 0) k = max<size_t>(1, (size_t)sqrt((double)n));
+        k = min(k, n);
+        
+        vector<vector<float>> features(n);
+        parallelFor(n, workerThreads, [&](size_t i) { features[i] = clusterFeatures(configDatabase[i]); });
+        const size_t dim = features[0].size();
+        
+        // Deterministic seeding: evenly spaced entries
+        vector<vector<float>> centroids(k);
+        for (size_t c = 0; c < k; ++c) centroids[c] = features[c * n / k];
+        
+        for (int iter = 0; iter < iterations; ++iter) {
+            atomic<size_t> changed{0};
+            parallelFor(n, workerThreads, [&](size_t i) {
+                uint32_t best = nearestCentroid(features[i], centroids);
+                if (best != clusterAssignments[i] || iter == 0) {
+                    clusterAssignments[i] = best;
+                    changed.fetch_add(1, memory_order_relaxed);
+                }
+            });
+            
+            vector<vector<float>> sums(k, vector<float>(dim, 0.0f));
+            vector<size_t> counts(k, 0);
+            for (size_t i = 0; i < n; ++i) {
+                auto& sum = sums[clusterAssignments[i]];
+                for (size_t d = 0; d < dim; ++d) sum[d] += features[i][d];
+                counts[clusterAssignments[i]]++;
+            }
+            for (size_t c = 0; c < k; ++c) {
+                if (counts[c] == 0) continue;  // Keep an empty cluster's previous centroid
+                for (size_t d = 0; d < dim; ++d) centroids[c][d] = sums[c][d] / counts[c];
+            }
+            
+            if (iter > 0 && changed.load() == 0) break;
+        }
+        
+        summarizeClusters(centroids);
+    }
+    
+    /**
+     * Pruning rate vs result quality: for each sampled anchor, compare exhaustive search
+     * with exact bound pruning and with 1/2/4-probe approximate descents.
+     */
+    json benchmarkClusterPruning(size_t maxAnchors = 100, int maxResults = 10) {
+        json report = json::object();
+        report["entries"] = configDatabase.size();
+        report["clusters"] = clusters.size();
+        report["max_results"] = maxResults;
+        
+        size_t anchorCount = min(maxAnchors, configDatabase.size());
+        vector<size_t> probeSettings = {0, 1, 2, 4};
+        map<size_t, double> prunedMs, pruningSum, recallSum;
+        double exhaustiveTotal = 0.0;
+        
+        for (size_t a = 0; a < anchorCount; ++a) {
+            const string& anchorId = configDatabase[a * configDatabase.size() / anchorCount].id;
+            
+            auto start = chrono::high_resolution_clock::now();
+            auto exhaustive = findCompatibleConfigurations(anchorId, maxResults);
+            exhaustiveTotal += chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+            set<string> truth;
+            for (const auto& [entry, result] : exhaustive) truth.insert(entry.id);
+            
+            for (size_t probes : probeSettings) {
+                ClusterSearchStats stats;
+                start = chrono::high_resolution_clock::now();
+                auto pruned = findCompatibleConfigurationsClustered(anchorId, maxResults, probes, &stats);
+                prunedMs[probes] += chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+                
+                size_t hits = 0;
+                for (const auto& [entry, result] : pruned) hits += truth.count(entry.id);
+                recallSum[probes] += truth.empty() ? 1.0 : (double)hits / truth.size();
+                pruningSum[probes] += stats.pruningRate();
+            }
+        }
+        
+        report["anchors"] = anchorCount;
+        report["exhaustive_ms_per_query"] = anchorCount ? exhaustiveTotal / anchorCount : 0.0;
+        json modes = json::array();
+        for (size_t probes : probeSettings) {
+            modes.push_back({
+                {"mode", probes == 0 ? "exact_bounds" : "probe_" + to_string(probes)},
+                {"ms_per_query", anchorCount ? prunedMs[probes] / anchorCount : 0.0},
+                {"pruning_rate", anchorCount ? pruningSum[probes] / anchorCount : 0.0},
+                {"recall_at_k", anchorCount ? recallSum[probes] / anchorCount : 0.0}
+            });
+        }
+        report["modes"] = modes;
+        return report;
+    }
+    
+private:
+    static constexpr const char* CLUSTER_ROLES[] = {"lead", "bass", "pad", "arp", "chord"};
+    static constexpr const char* CLUSTER_LAYERS[] = {"foreground", "midground", "background"};
+    static constexpr size_t CLUSTER_EMBEDDING_DIM = 5;
+    
+    static vector<float> unitEmbedding(const EnhancedConfigEntry& entry) {
+        vector<float> unit(CLUSTER_EMBEDDING_DIM, 0.0f);
+        float norm = 0.0f;
+        for (size_t d = 0; d < min(CLUSTER_EMBEDDING_DIM, entry.embedding.size()); ++d) {
+            norm += entry.embedding[d] * entry.embedding[d];
+        }
+        if (norm == 0.0f) return unit;
+        norm = sqrt(norm);
+        for (size_t d = 0; d < min(CLUSTER_EMBEDDING_DIM, entry.embedding.size()); ++d) {
+            unit[d] = entry.embedding[d] / norm;
+        }
+        return unit;
+    }
+    
+    // Combined feature vector: unit embedding, one-hot role (+other), one-hot layer, frequency ordinal
+    vector<float> clusterFeatures(const EnhancedConfigEntry& entry) const {
+        vector<float> features = unitEmbedding(entry);
+        
+        bool knownRole = false;
+        for (const char* role : CLUSTER_ROLES) {
+            bool match = entry.musicalRole.primaryRole == role;
+            knownRole |= match;
+            features.push_back(match ? 1.0f : 0.0f);
+        }
+        features.push_back(knownRole ? 0.0f : 1.0f);
+        
+        for (const char* layer : CLUSTER_LAYERS) {
+            features.push_back(entry.layeringInfo.preferredLayer == layer ? 0.5f : 0.0f);
+        }
+        
+        auto freqIt = layeringPointer.rules.frequencyRangeOrder.find(entry.layeringInfo.frequencyRange);
+        float freqOrdinal = freqIt != layeringPointer.rules.frequencyRangeOrder.end() ? stof(freqIt->second) : 2.0f;
+        features.push_back(0.5f * freqOrdinal / 5.0f);
+        return features;
+    }
+    
+    static uint32_t nearestCentroid(const vector<float>& point, const vector<vector<float>>& centroids) {
+        uint32_t best = 0;
+        float bestDist = numeric_limits<float>::infinity();
+        for (size_t c = 0; c < centroids.size(); ++c) {
+            float dist = 0.0f;
+            for (size_t d = 0; d < point.size(); ++d) {
+                float diff = point[d] - centroids[c][d];
+                dist += diff * diff;
+            }
+            if (dist < bestDist) {
+                bestDist = dist;
+                best = (uint32_t)c;
+            }
+        }
+        return best;
+    }
+    
+    json clusterCentroids() const {
+        json centroids = json::array();
+        for (const auto& cluster : clusters) centroids.push_back(cluster.centroid);
+        return centroids;
+    }
+    
+    void restoreClusters(const json& j) {
+        if (!j.contains("centroids") || !j.contains("assignments")) return;
+        vector<vector<float>> centroids = j["centroids"].get<vector<vector<float>>>();
+        vector<uint32_t> assignments = j["assignments"].get<vector<uint32_t>>();
+        if (centroids.empty() || assignments.size() != configDatabase.size()) return;
+        for (uint32_t c : assignments) {
+            if (c >= centroids.size()) return;
+        }
+        clusterAssignments = std::move(assignments);
+        summarizeClusters(centroids);
+    }
+    
+    // Derive per-cluster members and bound summaries from clusterAssignments
+    void summarizeClusters(const vector<vector<float>>& centroids) {
+        clusters.assign(centroids.size(), ConfigCluster());
+        for (size_t c = 0; c < centroids.size(); ++c) {
+            clusters[c].centroid = centroids[c];
+            clusters[c].embeddingCentroid.assign(CLUSTER_EMBEDDING_DIM, 0.0f);
+        }
+        
+        vector<vector<float>> units(configDatabase.size());
+        for (size_t i = 0; i < configDatabase.size(); ++i) {
+            const auto& entry = configDatabase[i];
+            ConfigCluster& cluster = clusters[clusterAssignments[i]];
+            cluster.members.push_back(i);
+            
+            units[i] = unitEmbedding(entry);
+            for (size_t d = 0; d < CLUSTER_EMBEDDING_DIM; ++d) cluster.embeddingCentroid[d] += units[i][d];
+            
+            cluster.roles.insert(entry.musicalRole.primaryRole);
+            cluster.contexts.insert(entry.musicalRole.musicalContext);
+            cluster.tonalCharacters.insert(entry.musicalRole.tonalCharacter);
+            cluster.layers.insert(entry.layeringInfo.preferredLayer);
+            cluster.frequencyRanges.insert(entry.layeringInfo.frequencyRange);
+            cluster.arrangementPositions.insert(entry.layeringInfo.arrangementPosition);
+            cluster.minProminence = min(cluster.minProminence, entry.musicalRole.prominence);
+            cluster.maxProminence = max(cluster.maxProminence, entry.musicalRole.prominence);
+            cluster.minMixPriority = min(cluster.minMixPriority, entry.layeringInfo.mixPriority);
+            cluster.maxMixPriority = max(cluster.maxMixPriority, entry.layeringInfo.mixPriority);
+            cluster.minStereoWidth = min(cluster.minStereoWidth, entry.layeringInfo.stereoWidth);
+            
+            unordered_map<string, int> tagCounts;
+            for (const string& tag : entry.semanticTags) tagCounts[tag]++;
+            for (const auto& [tag, count] : tagCounts) {
+                int& best = cluster.maxTagCount[tag];
+                best = max(best, count);
+            }
+        }
+        
+        for (auto& cluster : clusters) {
+            if (cluster.members.empty()) continue;
+            for (float& v : cluster.embeddingCentroid) v /= cluster.members.size();
+            for (size_t i : cluster.members) {
+                float dist = 0.0f;
+                for (size_t d = 0; d < CLUSTER_EMBEDDING_DIM; ++d) {
+                    float diff = units[i][d] - cluster.embeddingCentroid[d];
+                    dist += diff * diff;
+                }
+                cluster.embeddingRadius = max(cluster.embeddingRadius, sqrt(dist));
+            }
+        }
+    }
+    
+    /**
+     * Upper bound of analyzeCompatibility(anchor, m).overallScore over members m of the cluster.
+     * Each dimension is bounded by granting every check that at least one member could pass;
+     * the semantic cosine is bounded by anchor.centroid + radius (Cauchy-Schwarz).
+     */
+    float clusterScoreBound(const EnhancedConfigEntry& anchor, const vector<float>& anchorEmbedding,
+                            const ConfigCluster& cluster) const {
+        if (cluster.members.empty()) return 0.0f;
+        
+        // 1D semantic: cosine bound plus the largest possible shared-tag boost
+        float cosineBound = cluster.embeddingRadius;
+        for (size_t d = 0; d < CLUSTER_EMBEDDING_DIM; ++d) {
+            cosineBound += anchorEmbedding[d] * cluster.embeddingCentroid[d];
+        }
+        int sharedTags = 0;
+        for (const string& tag : anchor.semanticTags) {
+            auto it = cluster.maxTagCount.find(tag);
+            if (it != cluster.maxTagCount.end()) sharedTags += it->second;
+        }
+        float semanticBound = max(0.0f, min(cosineBound, 1.0f)) + sharedTags * 0.1f;
+        
+        // 2D technical: no cheap summary, assume a perfect match
+        float technicalBound = 1.0f;
+        
+        // 3D musical role
+        float roleBound = 0.0f;
+        auto compatibleIt = rolePointer.matrix.compatibleRoles.find(anchor.musicalRole.primaryRole);
+        if (compatibleIt != rolePointer.matrix.compatibleRoles.end()) {
+            for (const string& role : compatibleIt->second) {
+                if (cluster.roles.count(role)) { roleBound += 0.4f; break; }
+            }
+        }
+        if (anchor.musicalRole.musicalContext == "any" || cluster.contexts.count("any") ||
+            cluster.contexts.count(anchor.musicalRole.musicalContext)) {
+            roleBound += 0.2f;
+        }
+        if (fabs(anchor.musicalRole.prominence - cluster.minProminence) > 0.3f ||
+            fabs(anchor.musicalRole.prominence - cluster.maxProminence) > 0.3f) {
+            roleBound += 0.2f;
+        }
+        if (anchor.musicalRole.tonalCharacter == "neutral" || cluster.tonalCharacters.count("neutral") ||
+            cluster.tonalCharacters.count(anchor.musicalRole.tonalCharacter)) {
+            roleBound += 0.1f;
+        }
+        if (!anchor.musicalRole.typicalPartners.empty()) {
+            roleBound += 0.1f;
+        }
+        roleBound = min(roleBound, 1.0f);
+        
+        // 4D layering
+        float layeringBound = 0.0f;
+        auto layersIt = layeringPointer.rules.layerCompatibility.find(anchor.layeringInfo.preferredLayer);
+        if (layersIt != layeringPointer.rules.layerCompatibility.end()) {
+            for (const string& layer : layersIt->second) {
+                if (cluster.layers.count(layer)) { layeringBound += 0.3f; break; }
+            }
+        }
+        const string& freq = anchor.layeringInfo.frequencyRange;
+        if (freq == "full" || cluster.frequencyRanges.count("full") || cluster.frequencyRanges.size() > 1 ||
+            !cluster.frequencyRanges.count(freq)) {
+            layeringBound += 0.2f;
+        }
+        if (anchor.layeringInfo.stereoWidth + cluster.minStereoWidth <= 1.5f) {
+            layeringBound += 0.2f;
+        }
+        const string& position = anchor.layeringInfo.arrangementPosition;
+        if (position == "any" || cluster.arrangementPositions.count("any") || cluster.arrangementPositions.count(position)) {
+            layeringBound += 0.15f;
+        }
+        if (fabs(anchor.layeringInfo.mixPriority - cluster.minMixPriority) >= 0.2f ||
+            fabs(anchor.layeringInfo.mixPriority - cluster.maxMixPriority) >= 0.2f) {
+            layeringBound += 0.15f;
+        }
+        layeringBound = min(layeringBound, 1.0f);
+        
+        // Same weights as analyzeCompatibility, with slack for float rounding
+        return 0.2f * semanticBound + 0.3f * technicalBound + 0.3f * roleBound + 0.2f * layeringBound + 1e-4f;
+    }
+    
+public:
     /**
      * Generate a complete musical arrangement
      */
@@ -968,27 +1798,23 @@ public:
         MusicalArrangement arrangement;
         
         // Find lead instrument
-        auto leadCandidates = findByRole("lead");
-        if (!leadCandidates.empty()) {
-            arrangement.lead = leadCandidates[0];
+        for (size_t index : firstIndicesWhere(1, [](const auto& e) { return e.musicalRole.primaryRole == "lead"; })) {
+            arrangement.lead = configDatabase[index];
         }
         
         // Find bass instrument
-        auto bassCandidates = findByRole("bass");
-        if (!bassCandidates.empty()) {
-            arrangement.bass = bassCandidates[0];
+        for (size_t index : firstIndicesWhere(1, [](const auto& e) { return e.musicalRole.primaryRole == "bass"; })) {
+            arrangement.bass = configDatabase[index];
         }
         
         // Find harmony instruments
-        auto harmonyCandidates = findByRole("pad");
-        for (size_t i = 0; i < min((size_t)2, harmonyCandidates.size()); ++i) {
-            arrangement.harmony.push_back(harmonyCandidates[i]);
+        for (size_t index : firstIndicesWhere(2, [](const auto& e) { return e.musicalRole.primaryRole == "pad"; })) {
+            arrangement.harmony.push_back(configDatabase[index]);
         }
         
         // Add effects
-        auto effectCandidates = findByCategory("effect");
-        for (size_t i = 0; i < min((size_t)3, effectCandidates.size()); ++i) {
-            arrangement.effects.push_back(effectCandidates[i]);
+        for (size_t index : firstIndicesWhere(3, [](const auto& e) { return e.category == "effect"; })) {
+            arrangement.effects.push_back(configDatabase[index]);
         }
         
         // Calculate overall compatibility
@@ -1021,7 +1847,251 @@ public:
         
         return arrangement;
     }
-    
+
+    /**
+     * Section timeline: one arrangement per structure.json section, in song order.
+     * Intra-section pair scores and transition scores between adjacent sections
+     * are cached, so swapping one instrument only rescores the pairs it takes part in.
+     */
+    struct TimelineSection {
+        string name;                       // sectionName from structure.json
+        string anchorGroup;                // group mapped to this section
+        vector<size_t> slots;              // Indices into configDatabase
+        vector<vector<float>> pairScores;  // Symmetric slot x slot overall scores
+        float pairSum = 0.0f;              // Sum over the upper triangle of pairScores
+        float sectionTotal = 0.0f;         // Mean intra-section pair score
+    };
+
+    struct SectionTransition {
+        vector<vector<float>> crossScores; // sections[i].slots x sections[i + 1].slots
+        float crossSum = 0.0f;
+        float transitionScore = 0.0f;      // Mean cross-section pair score
+        float transitionCost = 1.0f;       // 1 - transitionScore
+    };
+
+    struct SectionTimeline {
+        vector<TimelineSection> sections;
+        vector<SectionTransition> transitions;  // transitions[i] joins sections[i] and sections[i + 1]
+        float timelineScore = 0.0f;             // Mean of all section totals and transition scores
+        size_t pairEvaluations = 0;             // Pair scores computed so far (build + swaps)
+    };
+
+    SectionTimeline buildSectionTimeline(const string& structureFile = "structure.json") {
+        SectionTimeline timeline;
+
+        ifstream inFile(structureFile);
+        if (!inFile) {
+            cerr << "Could not load " << structureFile << endl;
+            return timeline;
+        }
+        json structure;
+        inFile >> structure;
+        if (!structure.contains("sections") || !structure["sections"].is_array()) {
+            cerr << "No sections array in " << structureFile << endl;
+            return timeline;
+        }
+
+        for (const auto& sec : structure["sections"]) {
+            if (!sec.is_object() || !sec.contains("sectionName") || !sec["sectionName"].is_string()) continue;
+
+            TimelineSection section;
+            section.name = sec["sectionName"].get<string>();
+            if (sec.contains("group") && sec["group"].is_string()) {
+                section.anchorGroup = sec["group"].get<string>();
+            }
+            section.slots = arrangeSection(section.name, section.anchorGroup);
+            timeline.sections.push_back(section);
+        }
+
+        // Score every section and every adjacent transition once
+        for (auto& section : timeline.sections) {
+            size_t n = section.slots.size();
+            section.pairScores.assign(n, vector<float>(n, 0.0f));
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t j = i + 1; j < n; ++j) {
+                    float score = scoreSlotPair(section.slots[i], section.slots[j], timeline);
+                    section.pairScores[i][j] = section.pairScores[j][i] = score;
+                    section.pairSum += score;
+                }
+            }
+            updateSectionTotal(section);
+        }
+
+        for (size_t s = 0; s + 1 < timeline.sections.size(); ++s) {
+            const auto& from = timeline.sections[s];
+            const auto& to = timeline.sections[s + 1];
+            SectionTransition transition;
+            transition.crossScores.assign(from.slots.size(), vector<float>(to.slots.size(), 0.0f));
+            for (size_t i = 0; i < from.slots.size(); ++i) {
+                for (size_t j = 0; j < to.slots.size(); ++j) {
+                    float score = scoreSlotPair(from.slots[i], to.slots[j], timeline);
+                    transition.crossScores[i][j] = score;
+                    transition.crossSum += score;
+                }
+            }
+            updateTransitionTotal(transition);
+            timeline.transitions.push_back(transition);
+        }
+
+        updateTimelineScore(timeline);
+        return timeline;
+    }
+
+    /**
+     * Replace one instrument in one section. Only the swapped slot's row in the
+     * section matrix and its row/column in the two neighbouring transitions are rescored.
+     * Returns false (and changes nothing) if the instrument already sits in that section,
+     * since a section never pairs an instrument with itself.
+     */
+    bool swapTimelineInstrument(SectionTimeline& timeline, size_t sectionIndex,
+                                size_t slotIndex, const string& newId) {
+        if (sectionIndex >= timeline.sections.size()) return false;
+        TimelineSection& section = timeline.sections[sectionIndex];
+        if (slotIndex >= section.slots.size()) return false;
+
+        optional<size_t> newIndex = findIndexById(newId);
+        if (!newIndex) return false;
+        if (find(section.slots.begin(), section.slots.end(), *newIndex) != section.slots.end()) return false;
+        section.slots[slotIndex] = *newIndex;
+
+        // Intra-section: rescore the swapped slot's row, adjusting the running sum by delta
+        for (size_t j = 0; j < section.slots.size(); ++j) {
+            if (j == slotIndex) continue;
+            float score = scoreSlotPair(section.slots[slotIndex], section.slots[j], timeline);
+            section.pairSum += score - section.pairScores[slotIndex][j];
+            section.pairScores[slotIndex][j] = section.pairScores[j][slotIndex] = score;
+        }
+        updateSectionTotal(section);
+
+        // Incoming transition: the swapped slot is a column of the previous cross matrix
+        if (sectionIndex > 0) {
+            SectionTransition& incoming = timeline.transitions[sectionIndex - 1];
+            const auto& prevSlots = timeline.sections[sectionIndex - 1].slots;
+            for (size_t i = 0; i < prevSlots.size(); ++i) {
+                float score = scoreSlotPair(prevSlots[i], section.slots[slotIndex], timeline);
+                incoming.crossSum += score - incoming.crossScores[i][slotIndex];
+                incoming.crossScores[i][slotIndex] = score;
+            }
+            updateTransitionTotal(incoming);
+        }
+
+        // Outgoing transition: the swapped slot is a row of the next cross matrix
+        if (sectionIndex < timeline.transitions.size()) {
+            SectionTransition& outgoing = timeline.transitions[sectionIndex];
+            const auto& nextSlots = timeline.sections[sectionIndex + 1].slots;
+            for (size_t j = 0; j < nextSlots.size(); ++j) {
+                float score = scoreSlotPair(section.slots[slotIndex], nextSlots[j], timeline);
+                outgoing.crossSum += score - outgoing.crossScores[slotIndex][j];
+                outgoing.crossScores[slotIndex][j] = score;
+            }
+            updateTransitionTotal(outgoing);
+        }
+
+        updateTimelineScore(timeline);
+        return true;
+    }
+
+    const EnhancedConfigEntry& entryAt(size_t index) const {
+        return configDatabase[index];
+    }
+
+private:
+    optional<size_t> findIndexById(const string& id) const {
+        auto it = idIndex.find(id);
+        if (it == idIndex.end()) return nullopt;
+        return it->second;
+    }
+
+    // Anchor on the section's structure group, then add the best lead/bass/pad partners for it
+    vector<size_t> arrangeSection(const string& sectionName, const string& anchorGroup) {
+        vector<size_t> slots;
+        optional<size_t> anchor = findIndexById(anchorGroup);
+        if (!anchor) {
+            for (size_t i = 0; i < configDatabase.size(); ++i) {
+                if (configDatabase[i].musicalRole.primaryRole == "lead") { anchor = i; break; }
+            }
+        }
+        if (!anchor) return slots;
+        slots.push_back(*anchor);
+
+        string context = sectionName;
+        transform(context.begin(), context.end(), context.begin(), ::tolower);
+
+        const EnhancedConfigEntry& anchorEntry = configDatabase[*anchor];
+        for (const char* role : {"lead", "bass", "pad"}) {
+            if (anchorEntry.musicalRole.primaryRole == role) continue;
+
+            // Best (score, index) per block; merging in block order keeps the first maximum
+            vector<pair<float, optional<size_t>>> blockBest(
+                parallelBlockCount(configDatabase.size(), workerThreads), {-1.0f, nullopt});
+            parallelForBlocks(configDatabase.size(), workerThreads, [&](size_t block, size_t begin, size_t end) {
+                auto& [bestScore, best] = blockBest[block];
+                for (size_t i = begin; i < end; ++i) {
+                    const auto& candidate = configDatabase[i];
+                    if (candidate.musicalRole.primaryRole != role) continue;
+                    if (find(slots.begin(), slots.end(), i) != slots.end()) continue;
+
+                    float score = analyzeCompatibility(anchorEntry, candidate).overallScore;
+                    if (candidate.musicalRole.musicalContext == context) {
+                        score += 0.1f;  // Prefer instruments written for this section
+                    }
+                    if (score > bestScore) {
+                        bestScore = score;
+                        best = i;
+                    }
+                }
+            });
+
+            optional<size_t> best;
+            float bestScore = -1.0f;
+            for (const auto& [score, index] : blockBest) {
+                if (index && score > bestScore) {
+                    bestScore = score;
+                    best = index;
+                }
+            }
+            if (best) slots.push_back(*best);
+        }
+        return slots;
+    }
+
+    float scoreSlotPair(size_t a, size_t b, SectionTimeline& timeline) {
+        timeline.pairEvaluations++;
+        return analyzeCompatibility(configDatabase[a], configDatabase[b]).overallScore;
+    }
+
+    static void updateSectionTotal(TimelineSection& section) {
+        size_t n = section.slots.size();
+        size_t pairs = n > 1 ? n * (n - 1) / 2 : 0;
+        section.sectionTotal = pairs > 0 ? section.pairSum / pairs : 0.0f;
+    }
+
+    static void updateTransitionTotal(SectionTransition& transition) {
+        size_t pairs = transition.crossScores.empty() ? 0 :
+                       transition.crossScores.size() * transition.crossScores[0].size();
+        transition.transitionScore = pairs > 0 ? transition.crossSum / pairs : 0.0f;
+        transition.transitionCost = 1.0f - transition.transitionScore;
+    }
+
+    static void updateTimelineScore(SectionTimeline& timeline) {
+        float total = 0.0f;
+        for (const auto& section : timeline.sections) total += section.sectionTotal;
+        for (const auto& transition : timeline.transitions) total += transition.transitionScore;
+        size_t terms = timeline.sections.size() + timeline.transitions.size();
+        timeline.timelineScore = terms > 0 ? total / terms : 0.0f;
+    }
+
+    // First `limit` database indices matching pred; stops scanning early instead of copying every match
+    template <typename Pred>
+    vector<size_t> firstIndicesWhere(size_t limit, Pred pred) const {
+        vector<size_t> indices;
+        for (size_t i = 0; i < configDatabase.size() && indices.size() < limit; ++i) {
+            if (pred(configDatabase[i])) indices.push_back(i);
+        }
+        return indices;
+    }
+
+public:
     vector<EnhancedConfigEntry> findByRole(const string& role) {
         vector<EnhancedConfigEntry> results;
         for (const auto& entry : configDatabase) {
@@ -1045,6 +2115,12 @@ public:
     void printSystemStatistics() {
         cout << "\n=== MULTI-DIMENSIONAL POINTING SYSTEM STATISTICS ===" << endl;
         cout << "Total configurations: " << configDatabase.size() << endl;
+        configPool.printReport("Config field sharing");
+        if (shards) {
+            size_t resident = count_if(configDatabase.begin(), configDatabase.end(),
+                                       [](const EnhancedConfigEntry& entry) { return !entry.configData.empty(); });
+            cout << "Config bodies resident: " << resident << " (" << shards->shardsOpened() << " shard file(s) read)" << endl;
+        }
         
         map<string, int> categoryStats;
         map<string, int> roleStats;
@@ -1074,6 +2150,11 @@ public:
         cout << "=========================================================" << endl;
     }
     
+    // Dedup ratio and approximate bytes saved by sharing configData field values
+    json configSharingStats() const {
+        return configPool.stats();
+    }
+    
     /**
      * Export preset with full metadata
      */
@@ -1089,35 +2170,36 @@ public:
         json instruments = json::array();
         
         for (const string& id : configIds) {
-            auto entryIt = find_if(configDatabase.begin(), configDatabase.end(),
-                                  [&](const EnhancedConfigEntry& entry) { return entry.id == id; });
+            optional<size_t> index = findIndexById(id);
             
-            if (entryIt != configDatabase.end()) {
+            if (index) {
+                EnhancedConfigEntry& entry = configDatabase[*index];
+                ensureConfigData(entry);
                 json instrumentData = json::object();
-                instrumentData["id"] = entryIt->id;
-                instrumentData["name"] = entryIt->name;
-                instrumentData["category"] = entryIt->category;
-                instrumentData["config"] = entryIt->configData;
+                instrumentData["id"] = entry.id;
+                instrumentData["name"] = entry.name;
+                instrumentData["category"] = entry.category;
+                instrumentData["config"] = entry.configData.materialize();
                 
                 // Add multi-dimensional metadata
-                instrumentData["semantic_tags"] = entryIt->semanticTags;
+                instrumentData["semantic_tags"] = entry.semanticTags;
                 instrumentData["musical_role"] = {
-                    {"primary_role", entryIt->musicalRole.primaryRole},
-                    {"musical_context", entryIt->musicalRole.musicalContext},
-                    {"prominence", entryIt->musicalRole.prominence},
-                    {"tonal_character", entryIt->musicalRole.tonalCharacter}
+                    {"primary_role", entry.musicalRole.primaryRole},
+                    {"musical_context", entry.musicalRole.musicalContext},
+                    {"prominence", entry.musicalRole.prominence},
+                    {"tonal_character", entry.musicalRole.tonalCharacter}
                 };
                 instrumentData["layering_info"] = {
-                    {"preferred_layer", entryIt->layeringInfo.preferredLayer},
-                    {"frequency_range", entryIt->layeringInfo.frequencyRange},
-                    {"stereo_width", entryIt->layeringInfo.stereoWidth},
-                    {"mix_priority", entryIt->layeringInfo.mixPriority}
+                    {"preferred_layer", entry.layeringInfo.preferredLayer},
+                    {"frequency_range", entry.layeringInfo.frequencyRange},
+                    {"stereo_width", entry.layeringInfo.stereoWidth},
+                    {"mix_priority", entry.layeringInfo.mixPriority}
                 };
                 instrumentData["technical_specs"] = {
-                    {"sample_rate", entryIt->techSpecs.sampleRate},
-                    {"bit_depth", entryIt->techSpecs.bitDepth},
-                    {"envelope_type", entryIt->techSpecs.envelopeType},
-                    {"polyphony_limit", entryIt->techSpecs.polyphonyLimit}
+                    {"sample_rate", entry.techSpecs.sampleRate},
+                    {"bit_depth", entry.techSpecs.bitDepth},
+                    {"envelope_type", entry.techSpecs.envelopeType},
+                    {"polyphony_limit", entry.techSpecs.polyphonyLimit}
                 };
                 
                 instruments.push_back(instrumentData);
@@ -1130,13 +2212,11 @@ public:
         json compatibilityMatrix = json::object();
         for (size_t i = 0; i < configIds.size(); ++i) {
             for (size_t j = i + 1; j < configIds.size(); ++j) {
-                auto entryA = find_if(configDatabase.begin(), configDatabase.end(),
-                                     [&](const EnhancedConfigEntry& entry) { return entry.id == configIds[i]; });
-                auto entryB = find_if(configDatabase.begin(), configDatabase.end(),
-                                     [&](const EnhancedConfigEntry& entry) { return entry.id == configIds[j]; });
+                optional<size_t> entryA = findIndexById(configIds[i]);
+                optional<size_t> entryB = findIndexById(configIds[j]);
                 
-                if (entryA != configDatabase.end() && entryB != configDatabase.end()) {
-                    auto compatibility = analyzeCompatibility(*entryA, *entryB);
+                if (entryA && entryB) {
+                    auto compatibility = analyzeCompatibility(configDatabase[*entryA], configDatabase[*entryB]);
                     string pairKey = configIds[i] + "_" + configIds[j];
                     compatibilityMatrix[pairKey] = {
                         {"overall_score", compatibility.overallScore},
@@ -1155,11 +2235,230 @@ public:
     }
 };
 
+// Synthetic clean_config generator for scalability benchmarks. Value pools (name prefixes,
+// sound characteristics, manifold positions, synthesis kinds, effect counts) are sampled from
+// the real clean_config.json when it is available, so role/layer/context distributions match
+// the shipped presets. Only the fields the enrichment reads are emitted, which keeps 1M
+// entries within memory.
+class SyntheticConfigGenerator {
+public:
+    explicit SyntheticConfigGenerator(const string& templatePath = "clean_config.json", uint64_t seed = 42)
+        : rng(seed) {
+        ifstream templateFile(templatePath);
+        json templates;
+        if (templateFile) {
+            try {
+                templateFile >> templates;
+            } catch (const exception& e) {
+                cerr << "[Warn] Ignoring unreadable " << templatePath << ": " << e.what() << endl;
+            }
+        }
+        
+        for (auto it = templates.begin(); templates.is_object() && it != templates.end(); ++it) {
+            const string& name = it.key();
+            const json& config = it.value();
+            prefixes.push_back(name.substr(0, name.find('_')));
+            kinds.push_back(config.contains("guitarParams") ? "guitar" :
+                            config.contains("synthesisType") ? "synth" : "effect");
+            effectCounts.push_back(config.contains("effects") && config["effects"].is_array() ?
+                                   (int)config["effects"].size() : 0);
+            if (config.contains("adsr") && config["adsr"].contains("type")) {
+                envelopeTypes.push_back(config["adsr"]["type"].get<string>());
+            }
+            if (config.contains("topologicalMetadata") && config["topologicalMetadata"].contains("manifold_position")) {
+                positions.push_back(config["topologicalMetadata"]["manifold_position"].get<string>());
+            }
+            if (config.contains("soundCharacteristics")) {
+                const auto& chars = config["soundCharacteristics"];
+                if (chars.contains("timbral")) timbrals.push_back(chars["timbral"].get<string>());
+                if (chars.contains("material")) materials.push_back(chars["material"].get<string>());
+                if (chars.contains("dynamic")) dynamics.push_back(chars["dynamic"].get<string>());
+                for (const auto& emotion : chars.value("emotional", json::array())) {
+                    if (emotion.contains("tag")) emotions.push_back(emotion["tag"].get<string>());
+                }
+            }
+        }
+        
+        // Fallback pools when no template database is present
+        if (prefixes.empty()) {
+            prefixes = {"Lead", "Bass", "Pad", "Arp", "Chord", "Texture", "Bell", "Acoustic"};
+            kinds = {"synth", "synth", "synth", "synth", "synth", "synth", "synth", "guitar"};
+            effectCounts = {2, 2, 3, 1, 2, 3, 2, 0};
+        }
+        if (envelopeTypes.empty()) envelopeTypes = {"ADSR", "AHDSR"};
+        if (positions.empty()) positions = {"intro region", "verse support", "chorus peak", "bridge outlier", "outro region"};
+        if (timbrals.empty()) timbrals = {"bright", "warm", "dark", "lush", "gritty"};
+        if (materials.empty()) materials = {"analog", "digital", "wood", "metal"};
+        if (dynamics.empty()) dynamics = {"sustained", "percussive", "evolving"};
+        if (emotions.empty()) emotions = {"energetic", "calm", "dreamy", "intense", "warm"};
+    }
+    
+    /**
+     * Generate `count` configs keyed by unique names ("<Prefix>_<Timbral>_<n>").
+     */
+    json generate(size_t count) {
+        json configs = json::object();
+        for (size_t n = 0; n < count; ++n) {
+            size_t templateIndex = pick(prefixes.size());
+            const string& timbral = timbrals[pick(timbrals.size())];
+            
+            json config = {
+                {"adsr", {{"type", envelopeTypes[pick(envelopeTypes.size())]}}},
+                {"soundCharacteristics", {
+                    {"timbral", timbral},
+                    {"material", materials[pick(materials.size())]},
+                    {"dynamic", dynamics[pick(dynamics.size())]},
+                    {"emotional", json::array()}
+                }},
+                {"topologicalMetadata", {{"manifold_position", positions[pick(positions.size())]}}}
+            };
+            
+            size_t emotionCount = 1 + pick(2);
+            for (size_t e = 0; e < emotionCount; ++e) {
+                config["soundCharacteristics"]["emotional"].push_back({
+                    {"tag", emotions[pick(emotions.size())]},
+                    {"weight", 0.5 + 0.05 * pick(10)}
+                });
+            }
+            
+            const string& kind = kinds[templateIndex];
+            if (kind == "guitar") {
+                config["guitarParams"] = json::object();
+            } else if (kind == "synth") {
+                config["synthesisType"] = "subtractive";
+            }
+            int effects = effectCounts[templateIndex];
+            if (effects > 0) {
+                config["effects"] = json::array();
+                for (int e = 0; e < effects; ++e) config["effects"].push_back("fx" + to_string(e));
+            }
+            
+            configs[prefixes[templateIndex] + "_" + timbral + "_" + to_string(n)] = std::move(config);
+        }
+        return configs;
+    }
+    
+private:
+    mt19937_64 rng;
+    vector<string> prefixes, kinds, envelopeTypes, positions, timbrals, materials, dynamics, emotions;
+    vector<int> effectCounts;
+    
+    size_t pick(size_t n) {
+        return (size_t)(rng() % n);
+    }
+};
+
+/**
+ * Scalability benchmark: for each database size, generate a synthetic clean_config, write it to a
+ * temporary file and, per worker-thread count, time loading it (file read + parse, with the parse
+ * alone as parse_ms), enrichment, anchor queries, arrangement solving (generateArrangement +
+ * buildSectionTimeline) and preset export. Returns the JSON report.
+ */
+json runScalabilityBenchmark(const vector<size_t>& sizes, const vector<unsigned>& threadCounts, size_t queryCount) {
+    using Clock = chrono::high_resolution_clock;
+    auto elapsedMs = [](Clock::time_point start) {
+        return chrono::duration<double, milli>(Clock::now() - start).count();
+    };
+    
+    json report = {
+        {"hardware_concurrency", thread::hardware_concurrency()},
+        {"runs", json::array()}
+    };
+    
+    SyntheticConfigGenerator generator;
+    for (size_t size : sizes) {
+        cout << "Generating " << size << " synthetic configurations..." << endl;
+        filesystem::path sourcePath = filesystem::temp_directory_path() /
+                                      ("md_benchmark_source_" + to_string(size) + ".json");
+        size_t sourceBytes = 0;
+        {
+            string serialized = generator.generate(size).dump();
+            sourceBytes = serialized.size();
+            ofstream sourceFile(sourcePath, ios::binary);
+            sourceFile << serialized;
+            if (!sourceFile) throw runtime_error("Cannot write benchmark source " + sourcePath.string());
+        }
+        
+        for (unsigned threads : threadCounts) {
+            json run = {{"entries", size}, {"threads", threads}, {"source_bytes", sourceBytes}};
+            
+            auto start = Clock::now();
+            ifstream sourceFile(sourcePath, ios::binary);
+            string text((istreambuf_iterator<char>(sourceFile)), istreambuf_iterator<char>());
+            auto parseStart = Clock::now();
+            json cleanConfig = json::parse(text);
+            run["parse_ms"] = elapsedMs(parseStart);
+            run["load_ms"] = elapsedMs(start);
+            text = string();
+            
+            MultiDimensionalPointingSystem system(false);
+            system.workerThreads = threads;
+            start = Clock::now();
+            system.enrichConfigs(std::move(cleanConfig));
+            run["enrich_ms"] = elapsedMs(start);
+            run["config_sharing"] = system.configSharingStats();
+            
+            // Anchor queries spread evenly over the database
+            vector<double> latencies;
+            size_t matched = 0;
+            for (size_t q = 0; q < queryCount && size > 0; ++q) {
+                const string anchorId = system.entryAt(q * size / queryCount).id;
+                start = Clock::now();
+                matched += system.findCompatibleConfigurations(anchorId, 10).size();
+                latencies.push_back(elapsedMs(start));
+            }
+            sort(latencies.begin(), latencies.end());
+            double latencyTotal = accumulate(latencies.begin(), latencies.end(), 0.0);
+            run["query"] = {
+                {"count", latencies.size()},
+                {"mean_ms", latencies.empty() ? 0.0 : latencyTotal / latencies.size()},
+                {"p50_ms", latencies.empty() ? 0.0 : latencies[latencies.size() / 2]},
+                {"max_ms", latencies.empty() ? 0.0 : latencies.back()},
+                {"results", matched}
+            };
+            
+            start = Clock::now();
+            auto arrangement = system.generateArrangement("balanced", "any");
+            run["arrangement_ms"] = elapsedMs(start);
+            
+            start = Clock::now();
+            auto timeline = system.buildSectionTimeline();
+            run["timeline"] = {
+                {"ms", elapsedMs(start)},
+                {"sections", timeline.sections.size()},
+                {"score", timeline.timelineScore}
+            };
+            
+            vector<string> presetIds = {arrangement.lead.id, arrangement.bass.id};
+            for (const auto& harmony : arrangement.harmony) presetIds.push_back(harmony.id);
+            start = Clock::now();
+            json preset = system.exportPresetWithMetadata(presetIds);
+            run["export_ms"] = elapsedMs(start);
+            
+            cout << "  entries=" << size << " threads=" << threads << fixed << setprecision(1)
+                 << " load=" << run["load_ms"].get<double>() << "ms (parse " << run["parse_ms"].get<double>() << "ms)"
+                 << " enrich=" << run["enrich_ms"].get<double>() << "ms"
+                 << " dedup=" << run["config_sharing"]["dedup_ratio"].get<double>() << "x"
+                 << " query(mean)=" << run["query"]["mean_ms"].get<double>() << "ms"
+                 << " timeline=" << run["timeline"]["ms"].get<double>() << "ms" << endl;
+            report["runs"].push_back(run);
+        }
+        
+        error_code ec;
+        filesystem::remove(sourcePath, ec);
+    }
+    return report;
+}
+
 // Interactive demo and testing
-void runInteractiveDemo() {
+void runInteractiveDemo(const string& sourcePath = "clean_config.json", const string& patchPath = "") {
     cout << "=== MULTI-DIMENSIONAL POINTING SYSTEM DEMO ===" << endl;
     
-    MultiDimensionalPointingSystem system;
+    MultiDimensionalPointingSystem system(false);
+    system.loadConfigDatabase(sourcePath);
+    if (!patchPath.empty()) {
+        system.applyConfigPatch(patchPath);
+    }
     system.printSystemStatistics();
     
     // Find compatible configurations for a lead instrument
@@ -1180,6 +2479,20 @@ void runInteractiveDemo() {
         cout << endl << endl;
     }
     
+    // Same query with diversity-aware re-ranking
+    cout << "Diverse picks (diversity 0.5):";
+    for (const auto& [config, result] : system.findCompatibleConfigurations("Lead_Bright_Energetic", 5, 0.5f)) {
+        cout << " " << config.name;
+    }
+    cout << endl;
+    
+    // Same query through the cluster index (exact pruning)
+    MultiDimensionalPointingSystem::ClusterSearchStats clusterStats;
+    auto clusteredResults = system.findCompatibleConfigurationsClustered("Lead_Bright_Energetic", 5, 0, &clusterStats);
+    cout << "Cluster search: " << clusteredResults.size() << " results, probed " << clusterStats.clustersProbed
+         << "/" << clusterStats.clustersTotal << " clusters, scored " << clusterStats.entriesScored
+         << "/" << clusterStats.entriesTotal << " entries" << endl;
+    
     // Generate a complete musical arrangement
     cout << "\n=== Generating Musical Arrangement ===" << endl;
     auto arrangement = system.generateArrangement("balanced", "any");
@@ -1204,18 +2517,112 @@ void runInteractiveDemo() {
     
     cout << "Preset exported to multi_dimensional_preset.json" << endl;
     cout << "Preset contains " << preset["instruments"].size() << " instruments with full metadata." << endl;
+    
+    // Per-section arrangement over structure.json with incremental swaps
+    cout << "\n=== Section Timeline ===" << endl;
+    auto timeline = system.buildSectionTimeline("structure.json");
+    for (size_t s = 0; s < timeline.sections.size(); ++s) {
+        const auto& section = timeline.sections[s];
+        cout << "- " << section.name << " (score: " << fixed << setprecision(2) << section.sectionTotal << "): ";
+        for (size_t i = 0; i < section.slots.size(); ++i) {
+            if (i > 0) cout << ", ";
+            cout << system.entryAt(section.slots[i]).name;
+        }
+        cout << endl;
+        if (s < timeline.transitions.size()) {
+            cout << "    -> transition cost " << timeline.transitions[s].transitionCost << endl;
+        }
+    }
+    cout << "Timeline score: " << timeline.timelineScore 
+         << " (" << timeline.pairEvaluations << " pair evaluations)" << endl;
+    
+    if (timeline.sections.size() > 1 && timeline.sections[1].slots.size() > 1) {
+        // Swap in the first arrangement instrument the section does not already use
+        const auto& slots = timeline.sections[1].slots;
+        vector<const EnhancedConfigEntry*> candidates;
+        for (const auto* group : {&arrangement.harmony, &arrangement.rhythm, &arrangement.effects}) {
+            for (const auto& entry : *group) candidates.push_back(&entry);
+        }
+        candidates.push_back(&arrangement.lead);
+        candidates.push_back(&arrangement.bass);
+        auto replacement = find_if(candidates.begin(), candidates.end(), [&](const auto* entry) {
+            return !entry->id.empty() && none_of(slots.begin(), slots.end(), [&](size_t slot) {
+                return system.entryAt(slot).id == entry->id;
+            });
+        });
+        size_t before = timeline.pairEvaluations;
+        if (replacement != candidates.end() &&
+            system.swapTimelineInstrument(timeline, 1, slots.size() - 1, (*replacement)->id)) {
+            cout << "Swapped " << timeline.sections[1].name << " slot to " << (*replacement)->name
+                 << ": timeline score " << timeline.timelineScore << " ("
+                 << (timeline.pairEvaluations - before) << " pairs rescored)" << endl;
+        }
+    }
 }
 
-int main() {
+// Comma-separated list of unsigned integers ("10000,100000")
+template <typename T>
+vector<T> parseCountList(const string& text) {
+    vector<T> values;
+    stringstream ss(text);
+    string item;
+    while (getline(ss, item, ',')) {
+        if (!item.empty()) values.push_back((T)stoull(item));
+    }
+    return values;
+}
+
+int main(int argc, char* argv[]) {
     cout << "Multi-Dimensional Pointing System - Intelligent Configuration Assembly" << endl;
     cout << "=================================================================" << endl;
     
     try {
-        runInteractiveDemo();
+        if (argc > 1 && string(argv[1]) == "--cluster-benchmark") {
+            MultiDimensionalPointingSystem system;
+            json report = system.benchmarkClusterPruning();
+            cout << report.dump(2) << endl;
+            return 0;
+        }
+        
+        // --benchmark [--sizes 10000,100000,1000000] [--threads 1,2,4] [--queries 5] [--out file]
+        if (argc > 1 && string(argv[1]) == "--benchmark") {
+            vector<size_t> sizes = {10000, 100000, 1000000};
+            vector<unsigned> threadCounts = {1, 2, 4};
+            unsigned hardware = thread::hardware_concurrency();
+            if (hardware > 4) threadCounts.push_back(hardware);
+            size_t queries = 5;
+            string outPath = "md_benchmark_results.json";
+            
+            for (int i = 2; i + 1 < argc; i += 2) {
+                string flag = argv[i];
+                if (flag == "--sizes") sizes = parseCountList<size_t>(argv[i + 1]);
+                else if (flag == "--threads") threadCounts = parseCountList<unsigned>(argv[i + 1]);
+                else if (flag == "--queries") queries = stoull(argv[i + 1]);
+                else if (flag == "--out") outPath = argv[i + 1];
+                else cerr << "[Warn] Unknown benchmark option: " << flag << endl;
+            }
+            
+            json report = runScalabilityBenchmark(sizes, threadCounts, queries);
+            ofstream outFile(outPath);
+            outFile << report.dump(2) << endl;
+            cout << "Benchmark results written to " << outPath << endl;
+            return 0;
+        }
+        
+        // [--source <clean_config.json | clean_config.manifest.json>] [--patch <clean_config.patch.json|.cbor>]
+        string sourcePath = "clean_config.json", patchPath;
+        for (int i = 1; i + 1 < argc; i += 2) {
+            string flag = argv[i];
+            if (flag == "--source") sourcePath = argv[i + 1];
+            else if (flag == "--patch") patchPath = argv[i + 1];
+            else cerr << "[Warn] Unknown option: " << flag << endl;
+        }
+        
+        runInteractiveDemo(sourcePath, patchPath);
     } catch (const exception& e) {
         cerr << "Error: " << e.what() << endl;
         return 1;
     }
     
     return 0;
-}
\ No newline at end of file
+}
@@ -1,4 +1,5 @@
 #include "json.hpp"
+#include "pointing_shared.hpp"
 #include <iostream>
 #include <fstream>
 #include <map>
@@ -12,6 +13,12 @@
 #include <cmath>
 #include <chrono>
 #include <sstream>
+#include <limits>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <iomanip>
+#include <functional>
 
 using namespace std;
 using json = nlohmann::json;
@@ -27,7 +34,7 @@ struct ConfigEntry {
     string instrumentName;          // e.g., "Classical_Nylon_Soft"
     string category;               // e.g., "guitar", "group"
     string fieldType;              // e.g., "adsr", "oscillator", "effects"
-    json value;                    // The actual value
+    shared_ptr<const json> value;  // The actual value: an interned config field, or aliasing into one (null for instruments)
     vector<string> tags;           // Extracted semantic tags
     string explanation;            // Why this entry is relevant
     vector<float> embedding;       // Vector representation
@@ -292,23 +299,43 @@ private:
     map<string, vector<size_t>> categoryIndex; // category -> entry indices
     EmbeddingEngine embeddingEngine;
     SemanticKeywordDatabase skd;
-    json cleanConfig;
+    map<string, SharedConfigData> cleanConfig;  // Instrument name -> body as interned top-level fields
     json referenceData;
+    JsonInternPool valuePool;  // Owns the config: entries share or alias into these field nodes
+    
+    // Sharded source: cleanConfig starts as manifest headers, bodies replace them on first use
+    optional<CleanConfigShards> shards;
+    set<string> loadedInstruments;
     
 public:
-    PointingIndex() : skd(&embeddingEngine) {
-        loadAllData();
+    // configPath is clean_config.json or a *.manifest.json written by json_reader_system --sharded
+    explicit PointingIndex(const string& configPath = "clean_config.json") : skd(&embeddingEngine) {
+        loadAllData(configPath);
         buildPointingIndex();
     }
     
 private:
-    void loadAllData() {
+    void loadAllData(const string& configPath) {
         cout << "Loading all configuration data..." << endl;
         
         // Load clean config (actual renderable data)
-        ifstream configFile("clean_config.json");
-        if (configFile) {
-            configFile >> cleanConfig;
+        ifstream configFile(configPath);
+        if (configFile && CleanConfigShards::isManifestPath(configPath)) {
+            json manifest;
+            configFile >> manifest;
+            shards.emplace(manifest, configPath);
+            for (auto& [name, header] : shards->headers.items()) {
+                cleanConfig[name] = SharedConfigData::fromJson(header, valuePool);
+            }
+            cout << "Loaded shard manifest with " << cleanConfig.size() << " instruments/groups (bodies load on demand)." << endl;
+            cerr << "Sharded source: search covers manifest header fields (soundCharacteristics and scalars) until an "
+                 << "instrument's body is loaded; its nested blocks (adsr, oscillator, effects, ...) are indexed then" << endl;
+        } else if (configFile) {
+            json config;
+            configFile >> config;
+            for (auto& [name, body] : config.get_ref<json::object_t&>()) {
+                cleanConfig[name] = SharedConfigData::fromJson(std::move(body), valuePool);
+            }
             cout << "Loaded clean config with " << cleanConfig.size() << " instruments/groups." << endl;
         }
         
@@ -350,65 +377,85 @@ private:
         
         cout << "Built pointing index with " << allEntries.size() << " entries in " 
              << duration.count() << "ms." << endl;
+        valuePool.printReport("Resident config fields");
     }
     
     void indexConfigEntries() {
-        for (const auto& [instrumentName, instrumentData] : cleanConfig.items()) {
-            if (!instrumentData.is_object()) continue;
-            
-            string category = determineCategory(instrumentName, instrumentData);
-            
-            // Index the instrument itself
-            ConfigEntry instrumentEntry;
-            instrumentEntry.path = instrumentName;
-            instrumentEntry.instrumentName = instrumentName;
-            instrumentEntry.category = category;
-            instrumentEntry.fieldType = "instrument";
-            instrumentEntry.value = instrumentData;
-            instrumentEntry.tags = extractTags(instrumentData);
-            instrumentEntry.explanation = generateExplanation(instrumentName, instrumentData);
-            instrumentEntry.embedding = embeddingEngine.getEmbedding(
-                instrumentName + " " + instrumentEntry.explanation
-            );
-            
-            allEntries.push_back(instrumentEntry);
-            
-            // Recursively index all fields
-            indexFieldsRecursively(instrumentName, category, "", instrumentData);
+        for (const auto& [instrumentName, instrumentData] : cleanConfig) {
+            indexInstrument(instrumentName, instrumentData);
+        }
+    }
+    
+    void indexInstrument(const string& instrumentName, const SharedConfigData& instrumentData) {
+        json body = instrumentData.materialize();  // Scratch copy for scoring, dropped once indexed
+        string category = determineCategory(instrumentName, body);
+        
+        // Index the instrument itself; its fields are the entries that follow
+        ConfigEntry instrumentEntry;
+        instrumentEntry.path = instrumentName;
+        instrumentEntry.instrumentName = instrumentName;
+        instrumentEntry.category = category;
+        instrumentEntry.fieldType = "instrument";
+        instrumentEntry.tags = extractTags(body);
+        instrumentEntry.explanation = generateExplanation(instrumentName, body);
+        instrumentEntry.embedding = embeddingEngine.getEmbedding(
+            instrumentName + " " + instrumentEntry.explanation
+        );
+        
+        allEntries.push_back(instrumentEntry);
+        
+        // Index all fields; a sharded body not loaded yet only has its manifest header fields
+        // (nested blocks other than soundCharacteristics are null placeholders until then)
+        bool resident = !shards || loadedInstruments.count(instrumentName);
+        indexTopLevelFields(instrumentName, category, instrumentData,
+                            [&](const string&, const json& value) { return resident || !value.is_null(); });
+    }
+    
+    // Top-level fields are entries on their interned nodes; nested entries alias into those nodes,
+    // so the index holds no value the config does not already hold
+    void indexTopLevelFields(const string& instrumentName, const string& category, const SharedConfigData& data,
+                             const function<bool(const string&, const json&)>& include) {
+        const json* timbral = data.find("timbral");
+        for (const auto& [key, value] : data.fields) {
+            if (include(key, *value)) indexField(instrumentName, category, key, key, value, timbral);
         }
     }
     
     void indexFieldsRecursively(const string& instrumentName, const string& category, 
-                               const string& currentPath, const json& data) {
-        if (data.is_object()) {
-            for (const auto& [key, value] : data.items()) {
-                string newPath = currentPath.empty() ? key : currentPath + "." + key;
-                string fullPath = instrumentName + "." + newPath;
-                
-                ConfigEntry entry;
-                entry.path = fullPath;
-                entry.instrumentName = instrumentName;
-                entry.category = category;
-                entry.fieldType = determineFieldType(key, value);
-                entry.value = value;
-                entry.tags = extractTags(value);
-                entry.explanation = generateFieldExplanation(key, value, instrumentName);
-                
-                // Add context from parent
-                string contextText = key + " " + entry.explanation;
-                if (data.contains("timbral")) {
-                    contextText += " " + data["timbral"].get<string>();
-                }
-                
-                entry.embedding = embeddingEngine.getEmbedding(contextText);
-                
-                allEntries.push_back(entry);
-                
-                // Recurse into nested objects
-                if (value.is_object()) {
-                    indexFieldsRecursively(instrumentName, category, newPath, value);
-                }
-            }
+                               const string& currentPath, const json& data,
+                               const shared_ptr<const json>& owner) {
+        const json* timbral = data.contains("timbral") ? &data["timbral"] : nullptr;
+        for (auto it = data.begin(); it != data.end(); ++it) {
+            indexField(instrumentName, category, currentPath + "." + it.key(), it.key(),
+                       shared_ptr<const json>(owner, &it.value()), timbral);
+        }
+    }
+    
+    void indexField(const string& instrumentName, const string& category, const string& path,
+                    const string& key, shared_ptr<const json> node, const json* timbral) {
+        ConfigEntry entry;
+        entry.path = instrumentName + "." + path;
+        entry.instrumentName = instrumentName;
+        entry.category = category;
+        entry.value = std::move(node);
+        const json& value = *entry.value;
+        entry.fieldType = determineFieldType(key, value);
+        entry.tags = extractTags(value);
+        entry.explanation = generateFieldExplanation(key, value, instrumentName);
+        
+        // Add context from parent
+        string contextText = key + " " + entry.explanation;
+        if (timbral) {
+            contextText += " " + timbral->get<string>();
+        }
+        
+        entry.embedding = embeddingEngine.getEmbedding(contextText);
+        
+        allEntries.push_back(entry);
+        
+        // Recurse into nested objects
+        if (value.is_object()) {
+            indexFieldsRecursively(instrumentName, category, path, value, entry.value);
         }
     }
     
@@ -509,8 +556,8 @@ private:
         return "Parameter '" + key + "' for " + instrument;
     }
     
-    void buildTextIndexes() {
-        for (size_t i = 0; i < allEntries.size(); ++i) {
+    void buildTextIndexes(size_t firstEntry = 0) {
+        for (size_t i = firstEntry; i < allEntries.size(); ++i) {
             const auto& entry = allEntries[i];
             
             // Index path components
@@ -528,8 +575,8 @@ private:
             }
             
             // Index JSON value text
-            if (entry.value.is_string()) {
-                indexWords(entry.value.get<string>(), i);
+            if (entry.value && entry.value->is_string()) {
+                indexWords(entry.value->get<string>(), i);
             }
         }
     }
@@ -549,8 +596,9 @@ private:
     }
 
 public:
-    // Search functionality
-    vector<SearchResult> search(const string& query, const UserContext& context, int maxResults = 10) {
+    // Search functionality; diversity in [0, 1] applies MMR re-ranking against near-duplicate hits
+    vector<SearchResult> search(const string& query, const UserContext& context, int maxResults = 10,
+                                float diversity = 0.0f) {
         cout << "\n=== SEARCH: \"" << query << "\" ===" << endl;
         
         vector<SearchResult> results;
@@ -604,8 +652,12 @@ public:
                  return a.finalScore > b.finalScore;
              });
         
+        if (diversity > 0.0f && results.size() > (size_t)maxResults) {
+            results = diversifyResults(std::move(results), maxResults, diversity);
+        }
+        
         // Limit results
-        if (results.size() > maxResults) {
+        if (results.size() > (size_t)maxResults) {
             results.resize(maxResults);
         }
         
@@ -616,6 +668,29 @@ public:
     }
     
 private:
+    vector<SearchResult> diversifyResults(vector<SearchResult> ranked, int maxResults, float diversity) {
+        size_t dim = 0;
+        vector<float> relevance;
+        vector<const vector<float>*> embeddings;
+        relevance.reserve(ranked.size());
+        embeddings.reserve(ranked.size());
+        for (const auto& result : ranked) {
+            relevance.push_back(result.finalScore);
+            embeddings.push_back(&result.entry.embedding);
+            dim = max(dim, result.entry.embedding.size());
+        }
+        
+        vector<float> features = packUnitRows(embeddings, dim);
+        vector<size_t> order = selectMaximalMarginalRelevance(std::move(relevance), features, dim, maxResults, diversity);
+        
+        vector<SearchResult> diversified;
+        diversified.reserve(order.size());
+        for (size_t index : order) {
+            diversified.push_back(std::move(ranked[index]));
+        }
+        return diversified;
+    }
+    
     float computeTextScore(const string& query, const ConfigEntry& entry) {
         float score = 0.0f;
         string lowerQuery = toLowerCase(query);
@@ -745,9 +820,129 @@ private:
     }
 
 public:
+    /**
+     * Make an instrument's full body resident: fetch it from its shard, swap it in for the manifest
+     * header and index its fields. A no-op for unsharded sources and already loaded instruments.
+     */
+    bool ensureInstrumentLoaded(const string& instrumentName) {
+        if (!shards || loadedInstruments.count(instrumentName)) return true;
+        if (!cleanConfig.count(instrumentName)) return false;
+        
+        json body = shards->fetch(instrumentName);
+        if (!body.is_object()) {
+            cerr << "Could not load shard body for " << instrumentName << endl;
+            return false;
+        }
+        // Header fields are already indexed with the same values; index only what the body adds
+        set<string> indexed;
+        for (const auto& [key, value] : cleanConfig[instrumentName].fields) {
+            if (!value->is_null()) indexed.insert(key);
+        }
+        loadedInstruments.insert(instrumentName);
+        string category = determineCategory(instrumentName, body);
+        const SharedConfigData& instrumentData = cleanConfig[instrumentName] = SharedConfigData::fromJson(std::move(body), valuePool);
+        
+        size_t firstEntry = allEntries.size();
+        indexTopLevelFields(instrumentName, category, instrumentData,
+                            [&](const string& key, const json&) { return !indexed.count(key); });
+        buildTextIndexes(firstEntry);
+        return true;
+    }
+    
+    /**
+     * Apply a clean_config patch (json_reader_system --patch) in place of a reload: only the
+     * instruments it touches are patched and re-indexed, other entries keep their embeddings and
+     * learned boosts, and the word/path indexes are rebuilt over the result. Returns false and
+     * changes nothing when the patch does not apply to the loaded generation.
+     */
+    bool applyConfigPatch(const string& patchPath) {
+        json patch = readConfigPatch(patchPath);
+        if (!patch.is_array()) return false;
+        optional<set<string>> touched = patchedInstruments(patch);
+        if (!touched) {
+            cerr << "Patch " << patchPath << " replaces the whole config; reload it instead" << endl;
+            return false;
+        }
+        
+        // Patch a copy of the touched instruments before changing anything. Shard bodies not loaded
+        // yet are fetched for it and handed back to their shard if the patch does not apply.
+        json subset = json::object();
+        vector<string> fetched;
+        auto restoreFetched = [&]() {
+            for (const string& name : fetched) shards->restore(name, std::move(subset[name]));
+        };
+        for (const string& name : *touched) {
+            if (!cleanConfig.count(name)) continue;
+            if (shards && !loadedInstruments.count(name)) {
+                json body = shards->fetch(name);
+                if (!body.is_object()) {
+                    cerr << "Could not load shard body for " << name << endl;
+                    restoreFetched();
+                    return false;
+                }
+                fetched.push_back(name);
+                subset[name] = std::move(body);
+            } else {
+                subset[name] = cleanConfig[name].materialize();
+            }
+        }
+        try {
+            subset = subset.patch(patch);
+        } catch (const exception& e) {
+            cerr << "Patch " << patchPath << " does not apply to the loaded config: " << e.what() << endl;
+            restoreFetched();
+            return false;
+        }
+        
+        map<string, float> boosts;
+        vector<ConfigEntry> kept;
+        kept.reserve(allEntries.size());
+        for (auto& entry : allEntries) {
+            if (!touched->count(entry.instrumentName)) {
+                kept.push_back(std::move(entry));
+            } else if (entry.boostScore != 1.0f) {
+                boosts[entry.path] = entry.boostScore;
+            }
+        }
+        allEntries = std::move(kept);
+        
+        size_t firstEntry = allEntries.size();
+        for (const string& name : *touched) {
+            if (subset.contains(name)) {
+                cleanConfig[name] = SharedConfigData::fromJson(std::move(subset[name]), valuePool);
+                if (shards) loadedInstruments.insert(name);
+                indexInstrument(name, cleanConfig[name]);
+            } else {
+                cleanConfig.erase(name);
+                loadedInstruments.erase(name);
+            }
+        }
+        for (size_t i = firstEntry; i < allEntries.size(); ++i) {
+            auto boost = boosts.find(allEntries[i].path);
+            if (boost != boosts.end()) allEntries[i].boostScore = boost->second;
+        }
+        
+        textIndex.clear();
+        pathIndex.clear();
+        categoryIndex.clear();
+        buildTextIndexes();
+        
+        cout << "Applied patch " << patchPath << ": " << patch.size() << " operation(s) over " << touched->size()
+             << " instrument(s), " << (allEntries.size() - firstEntry) << " entries re-indexed" << endl;
+        return true;
+    }
+    
+    // Instrument name of an entry path ("Classical_Nylon_Soft.adsr.attack" -> "Classical_Nylon_Soft")
+    static string instrumentOf(const string& path) {
+        return path.substr(0, path.find('.'));
+    }
+    
+    size_t instrumentCount() const { return cleanConfig.size(); }
+    
     // Interactive operations
     vector<SearchResult> moreLikeThis(const string& path, const UserContext& context) {
         cout << "\n=== MORE LIKE: " << path << " ===" << endl;
+        ensureInstrumentLoaded(instrumentOf(path));
         
         // Find the reference entry
         const ConfigEntry* refEntry = nullptr;
@@ -774,6 +969,7 @@ public:
     
     void recordUserChoice(const string& path, bool positive, UserContext& context) {
         cout << "\n=== LEARNING: " << path << " (" << (positive ? "BOOST" : "DEMOTE") << ") ===" << endl;
+        ensureInstrumentLoaded(instrumentOf(path));
         
         // Update entry boost score
         for (auto& entry : allEntries) {
@@ -826,6 +1022,12 @@ public:
             cout << "  " << category << ": " << count << endl;
         }
         
+        valuePool.printReport("Resident config fields");
+        if (shards) {
+            cout << "Sharded source: " << loadedInstruments.size() << " of " << shards->size()
+                 << " instrument bodies loaded from " << shards->shardsOpened() << " shard file(s)" << endl;
+        }
+        
         cout << "SKD terms loaded: ";
         auto relatedToWarm = skd.findRelatedTerms("warm");
         cout << relatedToWarm.size() << " terms related to 'warm'" << endl;
@@ -833,9 +1035,23 @@ public:
         cout << "=================================" << endl;
     }
     
-    // Get clean config for rendering (only actual usable data)
+    // Get clean config for rendering (only actual usable data); loads every remaining shard body
     json getCleanConfigForSynthesis() {
-        return cleanConfig;
+        if (shards) {
+            vector<string> names;
+            for (const auto& [name, _] : cleanConfig) names.push_back(name);
+            for (const string& name : names) ensureInstrumentLoaded(name);
+        }
+        json config = json::object();
+        for (const auto& [name, body] : cleanConfig) config[name] = body.materialize();
+        return config;
+    }
+    
+    // One instrument for rendering; with a sharded source only its shard is read
+    json getInstrumentForSynthesis(const string& instrumentName) {
+        if (!ensureInstrumentLoaded(instrumentName)) return nullptr;
+        auto it = cleanConfig.find(instrumentName);
+        return it != cleanConfig.end() ? it->second.materialize() : json();
     }
 };
 
@@ -846,14 +1062,14 @@ private:
     UserContext context;
     
 public:
-    PointingSession() {
+    explicit PointingSession(const string& configPath = "clean_config.json") : index(configPath) {
         context.sessionId = generateSessionId();
         cout << "Started pointing session: " << context.sessionId << endl;
     }
     
     void runInteractiveSession() {
         cout << "\n=== POINTING INDEX INTERACTIVE SESSION ===" << endl;
-        cout << "Commands: search <query>, like <path>, exclude <path>, boost <path>, demote <path>, stats, config, quit" << endl;
+        cout << "Commands: search <query>, diverse <query>, like <path>, show <instrument>, patch <file>, exclude <path>, boost <path>, demote <path>, stats, config, quit" << endl;
         
         string input;
         while (true) {
@@ -873,10 +1089,23 @@ public:
                 string query = input.substr(7); // Skip "search "
                 auto results = index.search(query, context);
                 displaySearchResults(results);
+            } else if (command == "diverse" && parts.size() > 1) {
+                string query = input.substr(8); // Skip "diverse "
+                auto results = index.search(query, context, 10, 0.5f);
+                displaySearchResults(results);
             } else if (command == "like" && parts.size() > 1) {
                 string path = parts[1];
                 auto results = index.moreLikeThis(path, context);
                 displaySearchResults(results);
+            } else if (command == "show" && parts.size() > 1) {
+                json instrument = index.getInstrumentForSynthesis(parts[1]);
+                if (instrument.is_null()) {
+                    cout << "Unknown instrument: " << parts[1] << endl;
+                } else {
+                    cout << instrument.dump(2) << endl;
+                }
+            } else if (command == "patch" && parts.size() > 1) {
+                index.applyConfigPatch(parts[1]);
             } else if (command == "exclude" && parts.size() > 1) {
                 string path = parts[1];
                 context.excludedPaths.push_back(path);
@@ -892,9 +1121,9 @@ public:
                 printUserStats();
             } else if (command == "config") {
                 cout << "Clean config available for synthesis with " 
-                     << index.getCleanConfigForSynthesis().size() << " instruments/groups." << endl;
+                     << index.instrumentCount() << " instruments/groups." << endl;
             } else {
-                cout << "Unknown command. Try: search, like, exclude, boost, demote, stats, config, quit" << endl;
+                cout << "Unknown command. Try: search, diverse, like, show, patch, exclude, boost, demote, stats, config, quit" << endl;
             }
         }
     }
@@ -927,6 +1156,7 @@ private:
         cout << "\n--- SEARCH RESULTS ---" << endl;
         for (size_t i = 0; i < results.size(); ++i) {
             const auto& result = results[i];
+            index.ensureInstrumentLoaded(result.entry.instrumentName);  // Shown instruments become browsable
             cout << (i + 1) << ". " << result.entry.path << endl;
             cout << "   Category: " << result.entry.category 
                  << " | Type: " << result.entry.fieldType << endl;
@@ -969,12 +1199,13 @@ private:
     }
 };
 
-int main() {
+// Optional argument: config source, clean_config.json (default) or clean_config.manifest.json
+int main(int argc, char* argv[]) {
     cout << "Pointing Index System - Advanced Configuration Search & Suggestion" << endl;
     cout << "=================================================================" << endl;
     
     try {
-        PointingSession session;
+        PointingSession session(argc > 1 ? argv[1] : "clean_config.json");
         session.runInteractiveSession();
         
         cout << "\nSession ended. Thank you!" << endl;
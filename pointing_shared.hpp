@@ -0,0 +1,330 @@
+// Helpers shared by pointing_index_system.cpp and multi_dimensional_pointing_system.cpp.
+// Header-only so each system still builds with a single g++ line.
+#pragma once
+
+#include "json.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Maximal marginal relevance: pick k of n candidates trading relevance against redundancy.
+// Relevance is divided by the top score first, so it shares the [0, 1] scale of the cosine
+// similarities and a given diversity means the same whatever the query's or boosts' score range.
+// features holds one unit-length row of `dim` floats per candidate. maxSim[i] tracks the highest
+// similarity of candidate i to anything selected so far and is updated with one dot-product pass
+// per pick, so the whole selection costs O(n * k * dim).
+inline std::vector<size_t> selectMaximalMarginalRelevance(std::vector<float> relevance,
+                                                          const std::vector<float>& features,
+                                                          size_t dim, size_t k, float diversity) {
+    const size_t n = relevance.size();
+    const float lambda = 1.0f - std::max(0.0f, std::min(diversity, 1.0f));
+    k = std::min(k, n);
+    const float top = n ? *std::max_element(relevance.begin(), relevance.end()) : 0.0f;
+    if (top > 0.0f) {
+        for (float& r : relevance) r /= top;
+    }
+
+    std::vector<size_t> selected;
+    selected.reserve(k);
+    std::vector<float> maxSim(n, 0.0f);
+    std::vector<char> taken(n, 0);
+
+    while (selected.size() < k) {
+        size_t best = n;
+        float bestScore = -std::numeric_limits<float>::infinity();
+        for (size_t i = 0; i < n; ++i) {
+            if (taken[i]) continue;
+            float score = lambda * relevance[i] - (1.0f - lambda) * maxSim[i];
+            if (score > bestScore) {
+                bestScore = score;
+                best = i;
+            }
+        }
+        if (best == n) break;
+        taken[best] = 1;
+        selected.push_back(best);
+
+        const float* chosen = &features[best * dim];
+        for (size_t i = 0; i < n; ++i) {
+            const float* row = &features[i * dim];
+            float dot = 0.0f;
+            for (size_t d = 0; d < dim; ++d) dot += row[d] * chosen[d];
+            maxSim[i] = std::max(maxSim[i], dot);
+        }
+    }
+    return selected;
+}
+
+// Copy embeddings into one contiguous row-major matrix of unit rows (zero rows stay zero)
+inline std::vector<float> packUnitRows(const std::vector<const std::vector<float>*>& rows, size_t dim) {
+    std::vector<float> packed(rows.size() * dim, 0.0f);
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const std::vector<float>& v = *rows[i];
+        const size_t used = std::min(dim, v.size());
+        float norm = 0.0f;
+        for (size_t d = 0; d < used; ++d) norm += v[d] * v[d];
+        if (norm == 0.0f) continue;
+        norm = std::sqrt(norm);
+        for (size_t d = 0; d < used; ++d) packed[i * dim + d] = v[d] / norm;
+    }
+    return packed;
+}
+
+// Reader for the sharded clean_config layout (json_reader_system --sharded): a manifest maps each
+// instrument to a shard file and a small header; shard files are parsed on first use and each
+// body is handed out once, so only instruments that are actually touched stay in memory
+class CleanConfigShards {
+private:
+    std::filesystem::path shardDir;
+    std::map<std::string, std::string> shardOf;        // instrument -> shard file
+    std::map<std::string, nlohmann::json> openShards;  // shard file -> bodies not yet handed out
+
+public:
+    nlohmann::json headers = nlohmann::json::object();  // instrument -> header from the manifest
+
+    static bool isManifestPath(const std::string& path) {
+        const std::string suffix = ".manifest.json";
+        return path.size() >= suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    CleanConfigShards(const nlohmann::json& manifest, const std::string& manifestPath) {
+        shardDir = std::filesystem::path(manifestPath).parent_path() / manifest.value("shardDir", "clean_config_shards");
+        if (!manifest.contains("instruments") || !manifest["instruments"].is_object()) return;
+        for (const auto& [name, info] : manifest["instruments"].items()) {
+            shardOf[name] = info.value("shard", "");
+            headers[name] = info.contains("header") ? info["header"] : nlohmann::json::object();
+        }
+    }
+
+    size_t size() const { return shardOf.size(); }
+    size_t shardsOpened() const { return openShards.size(); }
+
+    // Body of one instrument, reading its shard on first use; null if it is missing
+    nlohmann::json fetch(const std::string& name) {
+        auto it = shardOf.find(name);
+        if (it == shardOf.end()) return nullptr;
+        auto [shard, inserted] = openShards.try_emplace(it->second, nlohmann::json::object());
+        if (inserted) {
+            std::ifstream shardFile(shardDir / it->second);
+            try {
+                if (shardFile) shardFile >> shard->second;
+            } catch (const std::exception& e) {
+                std::cerr << "Error reading shard " << it->second << ": " << e.what() << std::endl;
+            }
+        }
+        if (!shard->second.is_object() || !shard->second.contains(name)) return nullptr;
+        nlohmann::json body = std::move(shard->second[name]);
+        shard->second.erase(name);
+        return body;
+    }
+
+    // Give back a body taken with fetch() and not kept (e.g. a patch that did not apply)
+    void restore(const std::string& name, nlohmann::json body) {
+        auto it = shardOf.find(name);
+        if (it != shardOf.end()) openShards[it->second][name] = std::move(body);
+    }
+};
+
+// RFC 6902 patch written by json_reader_system --patch: JSON, or CBOR when the file ends in .cbor
+inline nlohmann::json readConfigPatch(const std::string& path) {
+    std::ifstream patchFile(path, std::ios::binary);
+    if (!patchFile) {
+        std::cerr << "Could not open patch " << path << std::endl;
+        return nullptr;
+    }
+    try {
+        if (path.size() > 5 && path.compare(path.size() - 5, 5, ".cbor") == 0) {
+            std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(patchFile)), std::istreambuf_iterator<char>());
+            return nlohmann::json::from_cbor(bytes);
+        }
+        nlohmann::json patch;
+        patchFile >> patch;
+        return patch;
+    } catch (const std::exception& e) {
+        std::cerr << "Could not read patch " << path << ": " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+// Instrument touched by a patch operation: the first reference token of a non-root JSON Pointer, unescaped
+inline std::string patchInstrument(const std::string& pointer) {
+    size_t end = pointer.find('/', 1);
+    std::string token = pointer.empty() ? "" : pointer.substr(1, end == std::string::npos ? std::string::npos : end - 1);
+    std::string name;
+    for (size_t i = 0; i < token.size(); ++i) {
+        if (token[i] == '~' && i + 1 < token.size()) {
+            name += token[++i] == '1' ? '/' : '~';
+        } else {
+            name += token[i];
+        }
+    }
+    return name;
+}
+
+// Instruments a patch touches (via "path" and "from"); nullopt if an operation targets the whole
+// document. Only the empty pointer is the root: "/" names the instrument keyed "" (RFC 6901).
+inline std::optional<std::set<std::string>> patchedInstruments(const nlohmann::json& patch) {
+    std::set<std::string> touched;
+    for (const auto& op : patch) {
+        for (const char* field : {"path", "from"}) {
+            if (!op.is_object() || !op.contains(field) || !op[field].is_string()) continue;
+            std::string pointer = op[field].get<std::string>();
+            if (pointer.empty()) return std::nullopt;
+            touched.insert(patchInstrument(pointer));
+        }
+    }
+    return touched;
+}
+
+// Hash-consing pool for immutable json subtrees: structurally equal values intern to one shared
+// node, so configs repeating the same effects array, adsr shape or metadata block hold it once.
+// Thread-safe (hashing and sizing run outside the lock). The table only holds weak references:
+// a node is freed with the last value handed out for it, and stats() counts live values only.
+class JsonInternPool {
+private:
+    // Live totals; shared with the deleters of handed-out values, which may outlive the pool
+    struct Totals {
+        std::atomic<size_t> values{0}, nodes{0}, bytesRequested{0}, bytesStored{0};
+    };
+    mutable std::mutex poolMutex;
+    std::unordered_map<size_t, std::vector<std::weak_ptr<const nlohmann::json>>> buckets;  // Structural hash -> nodes
+    std::shared_ptr<Totals> totals = std::make_shared<Totals>();
+
+public:
+    std::shared_ptr<const nlohmann::json> intern(nlohmann::json value) {
+        size_t hash = std::hash<nlohmann::json>{}(value);
+        size_t bytes = footprint(value);
+        std::shared_ptr<const nlohmann::json> node;
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            auto& bucket = buckets[hash];
+            for (const auto& weak : bucket) {
+                std::shared_ptr<const nlohmann::json> existing = weak.lock();
+                if (existing && *existing == value) {
+                    node = std::move(existing);
+                    break;
+                }
+            }
+            if (!node) {
+                std::shared_ptr<Totals> counts = totals;
+                node = std::shared_ptr<const nlohmann::json>(new nlohmann::json(std::move(value)),
+                    [counts, bytes](const nlohmann::json* released) {
+                        counts->nodes -= 1;
+                        counts->bytesStored -= bytes;
+                        delete released;
+                    });
+                totals->nodes += 1;
+                totals->bytesStored += bytes;
+                auto expired = std::find_if(bucket.begin(), bucket.end(), [](const auto& weak) { return weak.expired(); });
+                if (expired != bucket.end()) {
+                    *expired = node;
+                } else {
+                    bucket.push_back(node);
+                }
+            }
+        }
+
+        // Each interned value is its own handle on the node, so releasing it updates the live totals
+        totals->values += 1;
+        totals->bytesRequested += bytes;
+        const nlohmann::json* shared = node.get();
+        return std::shared_ptr<const nlohmann::json>(shared,
+            [node = std::move(node), counts = totals, bytes](const nlohmann::json*) mutable {
+                counts->values -= 1;
+                counts->bytesRequested -= bytes;
+                node.reset();
+            });
+    }
+
+    // Forget the table; values already handed out stay valid and counted until they are released
+    void clear() {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        buckets.clear();
+    }
+
+    // Live interned values, the distinct nodes behind them, and their approximate sizes
+    nlohmann::json stats() const {
+        size_t values = totals->values, nodes = totals->nodes;
+        size_t requested = totals->bytesRequested, stored = totals->bytesStored;
+        return {
+            {"values", values},
+            {"unique_nodes", nodes},
+            {"dedup_ratio", nodes ? (double)values / nodes : 1.0},
+            {"bytes_requested", requested},
+            {"bytes_stored", stored},
+            {"bytes_saved", requested > stored ? requested - stored : 0}
+        };
+    }
+
+    void printReport(const std::string& label) const {
+        nlohmann::json s = stats();
+        std::ostringstream ratio;  // Local stream: leave cout's float formatting alone
+        ratio << std::fixed << std::setprecision(2) << s["dedup_ratio"].get<double>();
+        std::cout << label << ": " << s["values"].get<size_t>() << " live values in " << s["unique_nodes"].get<size_t>()
+                  << " shared nodes (dedup " << ratio.str() << "x), ~"
+                  << s["bytes_stored"].get<size_t>() / 1024 << " KB of " << s["bytes_requested"].get<size_t>() / 1024
+                  << " KB, " << s["bytes_saved"].get<size_t>() / 1024 << " KB saved" << std::endl;
+    }
+
+    // Approximate heap footprint of a json value: the node plus string/array/object storage
+    static size_t footprint(const nlohmann::json& value) {
+        size_t bytes = sizeof(nlohmann::json);
+        if (value.is_string()) {
+            bytes += sizeof(std::string) + value.get_ref<const std::string&>().capacity();
+        } else if (value.is_array()) {
+            bytes += sizeof(nlohmann::json::array_t);
+            for (const nlohmann::json& element : value) bytes += footprint(element);
+        } else if (value.is_object()) {
+            bytes += sizeof(nlohmann::json::object_t);
+            for (const auto& [key, element] : value.get_ref<const nlohmann::json::object_t&>()) {
+                bytes += 4 * sizeof(void*) + sizeof(std::string) + key.capacity() + footprint(element);  // Tree node + key
+            }
+        }
+        return bytes;
+    }
+};
+
+// Config body as its top-level fields, each value interned in a JsonInternPool
+struct SharedConfigData {
+    std::vector<std::pair<std::string, std::shared_ptr<const nlohmann::json>>> fields;
+
+    static SharedConfigData fromJson(nlohmann::json body, JsonInternPool& pool) {
+        SharedConfigData data;
+        if (!body.is_object()) return data;
+        for (auto& [key, value] : body.get_ref<nlohmann::json::object_t&>()) {
+            data.fields.emplace_back(key, pool.intern(std::move(value)));
+        }
+        return data;
+    }
+
+    bool empty() const { return fields.empty(); }
+
+    // Interned node of a top-level field, or null
+    const nlohmann::json* find(const std::string& key) const {
+        for (const auto& [name, value] : fields) {
+            if (name == key) return value.get();
+        }
+        return nullptr;
+    }
+
+    nlohmann::json materialize() const {
+        nlohmann::json body = nlohmann::json::object();
+        for (const auto& [key, value] : fields) body[key] = *value;
+        return body;
+    }
+};